@@ -1,10 +1,22 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import media_player, sensor, text_sensor, uart
-from esphome.const import CONF_ID, CONF_UPDATE_INTERVAL, UNIT_PERCENT
+from esphome.components import binary_sensor, media_player, select, sensor, text_sensor, uart
+from esphome.const import (
+    CONF_COMMAND,
+    CONF_DELAY,
+    CONF_ID,
+    CONF_NAME,
+    CONF_UPDATE_INTERVAL,
+    DEVICE_CLASS_HEAT,
+    DEVICE_CLASS_PROBLEM,
+    DEVICE_CLASS_TEMPERATURE,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_CELSIUS,
+    UNIT_PERCENT,
+)
 
 DEPENDENCIES = ["uart"]
-AUTO_LOAD = ["media_player", "sensor", "text_sensor"]
+AUTO_LOAD = ["binary_sensor", "media_player", "select", "sensor", "text_sensor"]
 MULTI_CONF = True
 
 amplifier_serial_ns = cg.esphome_ns.namespace("amplifier_serial")
@@ -15,10 +27,120 @@ AmplifierSerial = amplifier_serial_ns.class_(
     media_player.MediaPlayer,
     cg.PollingComponent,
 )
+InputSourceSelect = amplifier_serial_ns.class_(
+    "InputSourceSelect",
+    select.Select,
+    cg.Parented.template(AmplifierSerial),
+)
+Command = amplifier_serial_ns.enum("Command", is_class=True)
 
 CONF_SOFTWARE_VERSION_SENSOR = "software_version_sensor"
 CONF_MAX_VOLUME_SENSOR = "max_volume_sensor"
 CONF_MAX_STREAMING_VOLUME_SENSOR = "max_streaming_volume_sensor"
+CONF_TITLE_SENSOR = "title_sensor"
+CONF_ARTIST_SENSOR = "artist_sensor"
+CONF_ALBUM_SENSOR = "album_sensor"
+CONF_AUDIO_ENCODER_SENSOR = "audio_encoder_sensor"
+CONF_AUDIO_SAMPLE_RATE_SENSOR = "audio_sample_rate_sensor"
+CONF_INPUT_SOURCE_SELECT = "input_source_select"
+CONF_DIRECT_MODE_SENSOR = "direct_mode_sensor"
+CONF_PROCESSOR_MODE_SENSOR = "processor_mode_sensor"
+CONF_PHONO_INPUT_TYPE_SENSOR = "phono_input_type_sensor"
+CONF_LIFTER_TEMPERATURE = "lifter_temperature"
+CONF_OUTPUT_TEMPERATURE = "output_temperature"
+CONF_AVERAGE = "average"
+CONF_MIN = "min"
+CONF_MAX = "max"
+CONF_OVERHEAT_SENSOR = "overheat_sensor"
+CONF_DC_OFFSET_SENSOR = "dc_offset_sensor"
+CONF_SHORT_CIRCUIT_SENSOR = "short_circuit_sensor"
+CONF_TELEMETRY_INTERVAL = "telemetry_interval"
+CONF_TELEMETRY_WINDOW = "telemetry_window"
+CONF_TEMPERATURE_THRESHOLD = "temperature_threshold"
+CONF_PRESETS = "presets"
+CONF_IR_MACROS = "ir_macros"
+CONF_STEPS = "steps"
+CONF_SYSTEM = "system"
+CONF_INPUT_SOURCE = "input_source"
+CONF_VOLUME = "volume"
+CONF_ROOM_EQ = "room_eq"
+CONF_BALANCE = "balance"
+CONF_DAC_FILTER = "dac_filter"
+CONF_DIRECT_MODE = "direct_mode"
+
+INPUT_SOURCES = {
+    "PHONO": 0x01,
+    "AUX": 0x02,
+    "PVR": 0x03,
+    "AV": 0x04,
+    "STB": 0x05,
+    "CD": 0x06,
+    "BD": 0x07,
+    "SAT": 0x08,
+    "GAME": 0x09,
+    "NET/USB": 0x0B,
+}
+
+# Names as reported by source_to_string
+SOURCE_NAMES = ["Phono", "AUX", "PVR", "AV", "STB", "CD", "BD", "SAT", "GAME", "NET/USB"]
+
+PRESET_SCHEMA = cv.Schema({
+    cv.Required(CONF_NAME): cv.string_strict,
+    cv.Optional(CONF_INPUT_SOURCE): cv.enum(INPUT_SOURCES, upper=True),
+    cv.Optional(CONF_VOLUME): cv.int_range(min=0, max=99),
+    cv.Optional(CONF_ROOM_EQ): cv.boolean,
+    cv.Optional(CONF_BALANCE): cv.int_range(min=-6, max=6),
+    cv.Optional(CONF_DAC_FILTER): cv.int_range(min=0, max=6),
+    cv.Optional(CONF_DIRECT_MODE): cv.boolean,
+})
+
+TEMPERATURE_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_CELSIUS,
+    accuracy_decimals=1,
+    device_class=DEVICE_CLASS_TEMPERATURE,
+    state_class=STATE_CLASS_MEASUREMENT,
+)
+
+TEMPERATURE_TELEMETRY_SCHEMA = cv.Schema({
+    cv.Optional(CONF_AVERAGE): TEMPERATURE_SENSOR_SCHEMA,
+    cv.Optional(CONF_MIN): TEMPERATURE_SENSOR_SCHEMA,
+    cv.Optional(CONF_MAX): TEMPERATURE_SENSOR_SCHEMA,
+})
+
+IR_STEP_SCHEMA = cv.Schema({
+    cv.Optional(CONF_SYSTEM, default=0x10): cv.hex_uint8_t,
+    cv.Required(CONF_COMMAND): cv.hex_uint8_t,
+    cv.Optional(CONF_DELAY, default="300ms"): cv.positive_time_period_milliseconds,
+})
+
+IR_MACRO_SCHEMA = cv.Schema({
+    cv.Required(CONF_NAME): cv.string_strict,
+    cv.Required(CONF_STEPS): cv.All(cv.ensure_list(IR_STEP_SCHEMA), cv.Length(min=1)),
+})
+
+def unique_names(items):
+    names = [item[CONF_NAME] for item in items]
+    for name in names:
+        if names.count(name) > 1:
+            raise cv.Invalid(f"Duplicate name '{name}'")
+    return items
+
+def preset_settings(config):
+    if CONF_INPUT_SOURCE in config:
+        yield Command.INPUT_SOURCE, INPUT_SOURCES[config[CONF_INPUT_SOURCE]]
+    if CONF_VOLUME in config:
+        yield Command.VOLUME, config[CONF_VOLUME]
+    if CONF_ROOM_EQ in config:
+        yield Command.ROOM_EQ, int(config[CONF_ROOM_EQ])
+    if CONF_BALANCE in config:
+        # Left balance is sent with the sign bit set
+        balance = config[CONF_BALANCE]
+        yield Command.BALANCE, balance if balance >= 0 else 0x80 | -balance
+    if CONF_DAC_FILTER in config:
+        yield Command.DAC_FILTER, config[CONF_DAC_FILTER]
+    if CONF_DIRECT_MODE in config:
+        # Per input setting, the device prefixes it with the input the preset applies to
+        yield Command.DIRECT_MODE, int(config[CONF_DIRECT_MODE])
 
 CONFIG_SCHEMA = (
     media_player.media_player_schema(AmplifierSerial).extend({
@@ -27,6 +149,25 @@ CONFIG_SCHEMA = (
         cv.Optional(CONF_SOFTWARE_VERSION_SENSOR): text_sensor.text_sensor_schema(),
         cv.Optional(CONF_MAX_VOLUME_SENSOR): sensor.sensor_schema(),
         cv.Optional(CONF_MAX_STREAMING_VOLUME_SENSOR): sensor.sensor_schema(),
+        cv.Optional(CONF_TITLE_SENSOR): text_sensor.text_sensor_schema(),
+        cv.Optional(CONF_ARTIST_SENSOR): text_sensor.text_sensor_schema(),
+        cv.Optional(CONF_ALBUM_SENSOR): text_sensor.text_sensor_schema(),
+        cv.Optional(CONF_AUDIO_ENCODER_SENSOR): text_sensor.text_sensor_schema(),
+        cv.Optional(CONF_AUDIO_SAMPLE_RATE_SENSOR): text_sensor.text_sensor_schema(),
+        cv.Optional(CONF_INPUT_SOURCE_SELECT): select.select_schema(InputSourceSelect),
+        cv.Optional(CONF_DIRECT_MODE_SENSOR): binary_sensor.binary_sensor_schema(),
+        cv.Optional(CONF_PROCESSOR_MODE_SENSOR): binary_sensor.binary_sensor_schema(),
+        cv.Optional(CONF_PHONO_INPUT_TYPE_SENSOR): text_sensor.text_sensor_schema(),
+        cv.Optional(CONF_LIFTER_TEMPERATURE): TEMPERATURE_TELEMETRY_SCHEMA,
+        cv.Optional(CONF_OUTPUT_TEMPERATURE): TEMPERATURE_TELEMETRY_SCHEMA,
+        cv.Optional(CONF_OVERHEAT_SENSOR): binary_sensor.binary_sensor_schema(device_class=DEVICE_CLASS_HEAT),
+        cv.Optional(CONF_DC_OFFSET_SENSOR): binary_sensor.binary_sensor_schema(device_class=DEVICE_CLASS_PROBLEM),
+        cv.Optional(CONF_SHORT_CIRCUIT_SENSOR): binary_sensor.binary_sensor_schema(device_class=DEVICE_CLASS_PROBLEM),
+        cv.Optional(CONF_TELEMETRY_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_TELEMETRY_WINDOW, default="5min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_TEMPERATURE_THRESHOLD, default=70): cv.temperature,
+        cv.Optional(CONF_PRESETS): cv.All(cv.ensure_list(PRESET_SCHEMA), unique_names),
+        cv.Optional(CONF_IR_MACROS): cv.All(cv.ensure_list(IR_MACRO_SCHEMA), unique_names),
     })
     .extend(uart.UART_DEVICE_SCHEMA)
     .extend(cv.polling_component_schema('15s'))
@@ -53,3 +194,70 @@ async def to_code(config):
     if CONF_MAX_STREAMING_VOLUME_SENSOR in config:
         sens = await sensor.new_sensor(config[CONF_MAX_STREAMING_VOLUME_SENSOR])
         cg.add(var.set_max_streaming_volume_sensor(sens))
+
+    if CONF_TITLE_SENSOR in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_TITLE_SENSOR])
+        cg.add(var.set_title_sensor(sens))
+
+    if CONF_ARTIST_SENSOR in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_ARTIST_SENSOR])
+        cg.add(var.set_artist_sensor(sens))
+
+    if CONF_ALBUM_SENSOR in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_ALBUM_SENSOR])
+        cg.add(var.set_album_sensor(sens))
+
+    if CONF_AUDIO_ENCODER_SENSOR in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_AUDIO_ENCODER_SENSOR])
+        cg.add(var.set_audio_encoder_sensor(sens))
+
+    if CONF_AUDIO_SAMPLE_RATE_SENSOR in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_AUDIO_SAMPLE_RATE_SENSOR])
+        cg.add(var.set_audio_sample_rate_sensor(sens))
+
+    if CONF_INPUT_SOURCE_SELECT in config:
+        sel = await select.new_select(config[CONF_INPUT_SOURCE_SELECT], options=SOURCE_NAMES)
+        await cg.register_parented(sel, var)
+        cg.add(var.set_input_source_select(sel))
+
+    if CONF_DIRECT_MODE_SENSOR in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_DIRECT_MODE_SENSOR])
+        cg.add(var.set_direct_mode_sensor(sens))
+
+    if CONF_PROCESSOR_MODE_SENSOR in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_PROCESSOR_MODE_SENSOR])
+        cg.add(var.set_processor_mode_sensor(sens))
+
+    if CONF_PHONO_INPUT_TYPE_SENSOR in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_PHONO_INPUT_TYPE_SENSOR])
+        cg.add(var.set_phono_input_type_sensor(sens))
+
+    for key, name in ((CONF_LIFTER_TEMPERATURE, "lifter_temperature"), (CONF_OUTPUT_TEMPERATURE, "output_temperature")):
+        for kind in (CONF_AVERAGE, CONF_MIN, CONF_MAX):
+            if kind in config.get(key, {}):
+                sens = await sensor.new_sensor(config[key][kind])
+                cg.add(getattr(var, f"set_{name}_{kind}_sensor")(sens))
+
+    if CONF_OVERHEAT_SENSOR in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_OVERHEAT_SENSOR])
+        cg.add(var.set_overheat_sensor(sens))
+
+    if CONF_DC_OFFSET_SENSOR in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_DC_OFFSET_SENSOR])
+        cg.add(var.set_dc_offset_sensor(sens))
+
+    if CONF_SHORT_CIRCUIT_SENSOR in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_SHORT_CIRCUIT_SENSOR])
+        cg.add(var.set_short_circuit_sensor(sens))
+
+    cg.add(var.set_telemetry_interval(config[CONF_TELEMETRY_INTERVAL]))
+    cg.add(var.set_telemetry_window(config[CONF_TELEMETRY_WINDOW]))
+    cg.add(var.set_temperature_threshold(config[CONF_TEMPERATURE_THRESHOLD]))
+
+    for preset in config.get(CONF_PRESETS, []):
+        for command, value in preset_settings(preset):
+            cg.add(var.add_preset_setting(preset[CONF_NAME], command, value))
+
+    for macro in config.get(CONF_IR_MACROS, []):
+        for step in macro[CONF_STEPS]:
+            cg.add(var.add_ir_macro_step(macro[CONF_NAME], step[CONF_SYSTEM], step[CONF_COMMAND], step[CONF_DELAY].total_milliseconds))
@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <cstring>
+#include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 #include "device.h"
 
@@ -8,25 +10,92 @@ namespace amplifier_serial {
 
 static const char *TAG = "amplifier_serial.device";
 
+// Cheap queries that are safe to send while the unit is still booting
+static const Command INIT_QUERIES[] = {
+  Command::INPUT_SOURCE,
+  Command::MAX_VOLUME,
+  Command::MAX_STREAMING_VOLUME,
+  Command::STANDBY_TIMEOUT,
+};
+static const size_t INIT_QUERY_COUNT = sizeof(INIT_QUERIES) / sizeof(INIT_QUERIES[0]);
+
+// Logs each null separated string of a streamed chunk
+static void log_text_chunk(const char *label, const char *text, size_t length) {
+  for (size_t offset = 0; offset < length; offset += strnlen(text + offset, length - offset) + 1) {
+    size_t part = strnlen(text + offset, length - offset);
+    if (part > 0) {
+      ESP_LOGD(TAG, "%s: %.*s", label, static_cast<int>(part), text + offset);
+    }
+  }
+}
+
 AmplifierSerial::AmplifierSerial(uart::UARTComponent *parent)
   : SerialTransport(parent), media_player::MediaPlayer(), CustomAPIDevice(), PollingComponent(POLLING_TIME) {
   set_frame_handler([this](const ResponseFrame& frame) {
     this->handle_frame(frame);
   });
+  set_chunk_handler([this](const ResponseFrame& frame, ChunkEvent event, const uint8_t *data, size_t length) {
+    this->handle_chunk(frame, event, data, length);
+  });
+  // Long text responses, no need to buffer them as a whole
+  for (auto command : {Command::SERVICE_DATA, Command::NOW_PLAYING_INFO, Command::ROOM_EQ_NAMES, Command::FRIENDLY_NAME}) {
+    stream_command(command);
+  }
 }
 
 void AmplifierSerial::setup() {
   SerialTransport::setup();
   this->state = media_player::MEDIA_PLAYER_STATE_IDLE;
   this->last_active_time_ = millis();
+  this->telemetry_window_start_ = millis();
+
+  // Sampled on its own schedule, only aggregates are published
+  if (this->has_telemetry_sensors()) {
+    this->set_interval("telemetry", this->telemetry_interval_, [this]() { this->sample_telemetry(); });
+  }
 
   // Register actions with the HA API
   this->register_service(&AmplifierSerial::on_turn_on, "turn_on");
   this->register_service(&AmplifierSerial::on_turn_off, "turn_off");
+  this->register_service(&AmplifierSerial::on_apply_preset, "apply_preset", {"preset"});
+  this->register_service(&AmplifierSerial::on_send_commands, "send_commands", {"commands"});
+  this->register_service(&AmplifierSerial::on_run_ir_macro, "run_ir_macro", {"macro"});
+  this->register_service(&AmplifierSerial::on_send_ir_codes, "send_ir_codes", {"codes"});
+  this->register_service(&AmplifierSerial::on_cancel_ir_macro, "cancel_ir_macro");
 }
 
 void AmplifierSerial::loop() {
   SerialTransport::loop();
+
+  if (this->is_link_quiet() && !this->has_pending_replies()) {
+    this->sleep_loop();
+  }
+}
+
+bool AmplifierSerial::has_pending_replies() const {
+  return this->preset_transaction_.is_active() || this->command_batch_.is_active() || this->ir_macro_runner_.is_awaiting_ack();
+}
+
+void AmplifierSerial::sleep_loop() {
+  ESP_LOGV(TAG, "Link quiet, stopping loop");
+  this->loop_sleeping_ = true;
+  this->disable_loop();
+  // There is no RX interrupt available to components, check for incoming bytes at a slow pace instead of every loop
+  this->set_interval("rx_wake", IDLE_RX_POLL_INTERVAL, [this]() {
+    if (this->available()) {
+      this->wake_loop();
+    }
+  });
+}
+
+void AmplifierSerial::wake_loop() {
+  if (!this->loop_sleeping_) {
+    return;
+  }
+  ESP_LOGV(TAG, "Resuming loop");
+  this->loop_sleeping_ = false;
+  this->cancel_interval("rx_wake");
+  this->enable_loop();
 }
 
 void AmplifierSerial::dump_config() {
@@ -34,7 +103,19 @@ void AmplifierSerial::dump_config() {
   ESP_LOGCONFIG(TAG, "  State: %s", state_to_string(this->state_));
   ESP_LOGCONFIG(TAG, "  Max Volume: %d", this->max_volume_);
   ESP_LOGCONFIG(TAG, "  Standby Timeout: %dmin", this->standby_timeout_ms_ / units::MINUTE);
+  ESP_LOGCONFIG(TAG, "  Telemetry Interval: %ds, Window: %ds", this->telemetry_interval_ / units::SECOND, this->telemetry_window_ / units::SECOND);
+  ESP_LOGCONFIG(TAG, "  Temperature Threshold: %.1f", this->temperature_threshold_);
+  for (const auto& preset : this->presets_) {
+    ESP_LOGCONFIG(TAG, "  Preset: %s (%u settings)", preset.name.c_str(), static_cast<unsigned>(preset.settings.size()));
+  }
+  for (const auto& macro : this->ir_macros_) {
+    ESP_LOGCONFIG(TAG, "  IR Macro: %s (%u steps)", macro.name.c_str(), static_cast<unsigned>(macro.steps.size()));
+  }
   this->check_uart_settings(UART_SPEED);
+  if (this->parent_->get_rx_buffer_size() < MIN_RX_BUFFER_SIZE) {
+    ESP_LOGW(TAG, "  UART rx_buffer_size %u is too small, set at least %u to avoid losing data while the loop sleeps",
+             static_cast<unsigned>(this->parent_->get_rx_buffer_size()), static_cast<unsigned>(MIN_RX_BUFFER_SIZE));
+  }
 }
 
 void AmplifierSerial::update() {
@@ -59,12 +140,7 @@ void AmplifierSerial::update() {
     case State::UNINITIALIZED:
       if (idle_time < INIT_TIME) break;
 
-      this->send_command(Command::MAX_VOLUME, STATUS_REQUEST);
-      this->send_command(Command::MAX_STREAMING_VOLUME, STATUS_REQUEST);
-      this->send_command(Command::STANDBY_TIMEOUT, STATUS_REQUEST);
-      // Only call System Status once, it takes a while to respond, and cannot be interrupted to successfully complete
-      this->send_command(Command::SYSTEM_STATUS, STATUS_REQUEST);
-      this->state_ = State::INITIALIZING;
+      this->start_initialization();
       break;
 
     case State::INITIALIZING:
@@ -85,9 +161,18 @@ void AmplifierSerial::update() {
 
     case State::PLAYING:
       // Periodic updates seems to reset EuP standby timer
-      this->send_command(Command::LIFTER_TEMPERATURE, STATUS_REQUEST);
-      this->send_command(Command::OUTPUT_TEMPERATURE, STATUS_REQUEST);
       this->send_command(Command::INPUT_DETECT, STATUS_REQUEST);
+      if (this->has_now_playing_sensors()) {
+        // Changes trigger fetching of the affected now playing fields
+        this->send_command(Command::AUDIO_SAMPLE_RATE, STATUS_REQUEST);
+        if (this->input_source_ == NET_USB_SOURCE) {
+          this->send_command(Command::NETWORK_PLAYBACK, STATUS_REQUEST);
+          // Title is cheap, other track fields are fetched only when it changes
+          this->now_playing_.invalidate(NowPlayingField::TITLE);
+          this->fetch_now_playing();
+        }
+      }
+      this->prefetch_source_state();
       break;
   }
 
@@ -97,23 +182,84 @@ void AmplifierSerial::update() {
 }
 
 void AmplifierSerial::handle_frame(const ResponseFrame& frame) {
+  if (this->preset_transaction_.handle_reply(frame)) {
+    this->finish_preset();
+  }
+  if (this->ir_macro_runner_.is_ack(frame)) {
+    this->handle_ir_ack(frame);
+  }
+  if (this->command_batch_.handle_reply(frame.zone, frame.command_code, frame.answer_code, frame.data.data(), frame.data.size())) {
+    this->finish_command_batch();
+  }
+  if (this->state_ == State::INITIALIZING) {
+    this->handle_init_reply(frame);
+  }
+
+  bool prefetch_reply = this->prefetch_pending_ && frame.command_code == this->prefetch_command_;
+  if (prefetch_reply) {
+    this->prefetch_pending_ = false;
+    this->cancel_timeout("prefetch_timeout");
+    // When the unit is busy the value stays unknown and the next update asks again
+    if (frame.answer_code != Answer::COMMAND_INVALID_TMP) {
+      if (frame.answer_code != Answer::STATUS_UPDATE) {
+        // Setting doesn't exist for this input, don't ask again
+        this->source_states_.store(this->prefetch_command_, this->prefetch_source_, VALUE_UNSUPPORTED);
+      }
+      this->defer("prefetch", [this]() { this->prefetch_source_state(); });
+    }
+  }
+
   if (!SerialTransport::handle_frame(frame)) {
+    if (frame.command_code == Command::NOW_PLAYING_INFO) {
+      // Field not available for current stream, continue with the next one
+      this->cancel_timeout("now_playing");
+      this->now_playing_.cancel_pending();
+      this->fetch_now_playing();
+    } else if (frame.command_code == Command::INPUT_SOURCE) {
+      // Switch was rejected, show the input that is still active
+      this->cancel_timeout("select_source");
+      this->publish_input_source(this->input_source_);
+    }
     return;
   }
 
   State prev_state = this->state_;
 
+  // Per input settings are cached in source_states_, see handle_source_setting
+  if (is_preset_command(frame.command_code) && !is_per_input_command(frame.command_code) && frame.data.size() >= 1) {
+    this->settings_[frame.command_code] = frame.command_code == Command::INPUT_SOURCE ? frame.data[0] & 0x0F : frame.data[0];
+  }
+
   switch (frame.command_code) {
     case Command::POWER:
       if (frame.data.size() >= 1) {
         uint8_t power_on = frame.data[0];
         if (power_on == 0x01) {
           this->last_active_time_ = millis();
+          this->cancel_timeout("turn_on");
           if (this->state_ <= State::UNAVAILABLE) {
             this->state_ = State::UNINITIALIZED;
+            this->power_on_time_ = millis();
+            if (this->turn_on_time_ != 0) {
+              // We asked for it, so the unit is booting now, don't wait for the next update
+              this->start_initialization();
+            }
           }
         } else if (power_on == 0x00) {
           this->state_ = State::UNAVAILABLE;
+          this->turn_on_time_ = 0;
+          this->cancel_timeout("turn_on");
+          this->init_pending_ = 0;
+          this->cancel_timeout("init");
+          this->clear_now_playing();
+          this->settings_.clear();  // Changes made in standby are not reported
+          this->source_states_.clear();
+          this->prefetch_pending_ = false;
+          // Partial window would skew the aggregates of the next session
+          this->lifter_temperature_.reset();
+          this->output_temperature_.reset();
+          this->network_playback_ = 0xFF;
+          this->audio_sample_rate_ = 0xFF;
         }
         this->state = frame.data[0] == 0x01 ? media_player::MEDIA_PLAYER_STATE_IDLE : media_player::MEDIA_PLAYER_STATE_NONE;
       }
@@ -139,11 +285,29 @@ void AmplifierSerial::handle_frame(const ResponseFrame& frame) {
 
     case Command::INPUT_SOURCE:
       if (frame.data.size() >= 1) {
-        ESP_LOGD(TAG, "Input source: %s", source_to_string(frame.data[0] & 0x0F));
-        // this->source = input_sources[frame.data[0] & 0x0F];
+        this->cancel_timeout("select_source");
+        // Select may show a requested input, publish even when the input didn't change
+        this->publish_input_source(frame.data[0] & 0x0F);
+      }
+      if (frame.data.size() >= 1 && (frame.data[0] & 0x0F) != this->input_source_) {
+        this->input_source_ = frame.data[0] & 0x0F;
+        ESP_LOGD(TAG, "Input source: %s", source_to_string(this->input_source_));
+        if (this->input_source_ == NET_USB_SOURCE) {
+          this->now_playing_.invalidate_track();
+          this->now_playing_.invalidate_format();
+          this->fetch_now_playing();
+        } else {
+          this->clear_now_playing();  // Track info of the network stream doesn't apply to other inputs
+        }
       }
       break;
 
+    case Command::DIRECT_MODE:
+    case Command::PROCESSOR_MODE_INPUT:
+    case Command::PHONO_INPUT_TYPE:
+      this->handle_source_setting(frame, prefetch_reply);
+      break;
+
     case Command::STANDBY_TIMEOUT:
       if (frame.data.size() >= 1) {
         this->standby_timeout_ms_ = standby_timeout_to_ms(frame.data[0]);
@@ -163,9 +327,59 @@ void AmplifierSerial::handle_frame(const ResponseFrame& frame) {
       }
       break;
 
+    case Command::NETWORK_PLAYBACK:
+      if (frame.data.size() >= 1 && frame.data[0] != this->network_playback_) {
+        this->network_playback_ = frame.data[0];
+        this->now_playing_.invalidate_track();
+        this->now_playing_.invalidate_format();
+        this->fetch_now_playing();
+      }
+      break;
+
+    case Command::AUDIO_SAMPLE_RATE:
+      if (frame.data.size() >= 1 && frame.data[0] != this->audio_sample_rate_) {
+        this->audio_sample_rate_ = frame.data[0];
+        if (this->audio_sample_rate_sensor_ != nullptr) {
+          this->audio_sample_rate_sensor_->publish_state(sample_rate_to_string(this->audio_sample_rate_));
+        }
+        this->now_playing_.invalidate_format();
+        this->fetch_now_playing();
+      }
+      break;
+
+    case Command::LIFTER_TEMPERATURE:
+      if (frame.data.size() >= 1) {
+        this->lifter_temperature_.add(frame.data[0]);
+        this->check_overheat();
+      }
+      break;
+
+    case Command::OUTPUT_TEMPERATURE:
+      if (frame.data.size() >= 1) {
+        this->output_temperature_.add(frame.data[0]);
+        this->check_overheat();
+      }
+      break;
+
+    case Command::DC_OFFSET:
+      if (frame.data.size() >= 1) {
+        this->publish_protection(this->dc_offset_sensor_, this->dc_offset_, frame.data[0]);
+      }
+      break;
+
+    case Command::SHORT_CIRCUIT_STATUS:
+      if (frame.data.size() >= 1) {
+        this->publish_protection(this->short_circuit_sensor_, this->short_circuit_, frame.data[0]);
+      }
+      break;
+
     case Command::SYSTEM_STATUS:
       if (frame.data.size() >= 1 && frame.data[0] == 0xF0) {
         this->state_ = State::IDLE; // Inilization done
+        if (this->turn_on_time_ != 0) {
+          ESP_LOGI(TAG, "Amplifier ready %ums after turn on", static_cast<unsigned>(millis() - this->turn_on_time_));
+          this->turn_on_time_ = 0;
+        }
       }
       break;
 
@@ -189,16 +403,7 @@ void AmplifierSerial::handle_frame(const ResponseFrame& frame) {
         this->max_streaming_volume_sensor_->publish_state(frame.data[0]);
       }
       break;
-      
-    case Command::SERVICE_DATA:
-      if (frame.data.size() >= 5) {
-        uint8_t offset = 4;
-        uint16_t f_type = frame.data[0] & frame.data[1] << 8;
-        uint16_t c_type = frame.data[2] & frame.data[3] << 8;
-        auto null_pos = std::find(frame.data.begin(), frame.data.end(), '\0');
-        ESP_LOGD(TAG, "%04X %04X: %s", f_type, c_type, std::string(frame.data.begin() + offset, null_pos).c_str());
-      }
-      break;
+
     default:
       ESP_LOGD(TAG, "Unhandled command: %s (%02X)", command_to_string(frame.command_code), static_cast<uint8_t>(frame.command_code));
       break;
@@ -211,6 +416,392 @@ void AmplifierSerial::handle_frame(const ResponseFrame& frame) {
   this->publish_state(); // MediaPlayer state update
 }
 
+void AmplifierSerial::start_initialization() {
+  this->state_ = State::INITIALIZING;
+  this->init_pending_ = (1 << INIT_QUERY_COUNT) - 1;
+  this->system_status_retries_ = 0;
+
+  // Don't wait forever if some query keeps failing, proceed the old way after init time
+  this->set_timeout("init", INIT_TIME, [this]() { this->finish_init_queries(); });
+  this->send_init_queries();
+}
+
+void AmplifierSerial::send_init_queries() {
+  for (size_t i = 0; i < INIT_QUERY_COUNT; i++) {
+    if ((this->init_pending_ & (1 << i)) && !this->send_command(INIT_QUERIES[i], STATUS_REQUEST)) {
+      this->init_pending_ &= ~(1 << i);  // Not supported, nothing to wait for
+    }
+  }
+  if (this->init_pending_ == 0) {
+    this->finish_init_queries();
+  }
+}
+
+void AmplifierSerial::handle_init_reply(const ResponseFrame& frame) {
+  if (frame.command_code == Command::SYSTEM_STATUS) {
+    if (frame.answer_code == Answer::STATUS_UPDATE && frame.data.size() >= 1 && frame.data[0] == 0xF0) {
+      this->cancel_timeout("init");
+    } else {
+      this->retry_system_status();
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < INIT_QUERY_COUNT; i++) {
+    if (INIT_QUERIES[i] != frame.command_code || !(this->init_pending_ & (1 << i))) {
+      continue;
+    }
+    if (frame.answer_code == Answer::COMMAND_INVALID_TMP) {
+      // Still booting, retry soon instead of waiting the whole init time
+      this->set_timeout("init_retry", INIT_RETRY_DELAY, [this]() { this->send_init_queries(); });
+      return;
+    }
+    this->init_pending_ &= ~(1 << i);
+    if (this->init_pending_ == 0) {
+      this->finish_init_queries();
+    }
+    return;
+  }
+}
+
+void AmplifierSerial::finish_init_queries() {
+  if (this->state_ != State::INITIALIZING) {
+    return;
+  }
+  this->cancel_timeout("init");
+  this->cancel_timeout("init_retry");
+  // Init time is over, queries still without a valid reply get one more try, late replies are handled as usual
+  for (size_t i = 0; i < INIT_QUERY_COUNT; i++) {
+    if (this->init_pending_ & (1 << i)) {
+      this->send_command(INIT_QUERIES[i], STATUS_REQUEST);
+    }
+  }
+  this->init_pending_ = 0;
+
+  // Cheap queries may be done right after a requested turn on, System Status waits until the unit booted
+  uint32_t since_power_on = millis() - this->power_on_time_;
+  if (since_power_on < INIT_TIME) {
+    this->set_timeout("init", INIT_TIME - since_power_on, [this]() { this->send_system_status(); });
+    return;
+  }
+  this->send_system_status();
+}
+
+void AmplifierSerial::send_system_status() {
+  // Only call System Status once at a time, it takes a while to respond, and cannot be interrupted to successfully complete
+  this->send_command(Command::SYSTEM_STATUS, STATUS_REQUEST);
+  this->set_timeout("init", INIT_TIME, [this]() { this->retry_system_status(); });
+}
+
+void AmplifierSerial::retry_system_status() {
+  if (this->state_ != State::INITIALIZING) {
+    return;
+  }
+  if (++this->system_status_retries_ > SYSTEM_STATUS_MAX_RETRIES) {
+    ESP_LOGW(TAG, "Amplifier not ready, restarting initialization");
+    this->cancel_timeout("init");
+    this->state_ = State::UNINITIALIZED;
+    return;
+  }
+  this->set_timeout("init", INIT_RETRY_DELAY, [this]() { this->send_system_status(); });
+}
+
+void AmplifierSerial::select_source(uint8_t source) {
+  if (!this->is_on()) {
+    ESP_LOGW(TAG, "Cannot select %s, amplifier is not on", source_to_string(source));
+    return;
+  }
+  if (!this->send_command(Command::INPUT_SOURCE, source)) {
+    this->publish_input_source(this->input_source_);
+    return;
+  }
+  // Settings of the new input are cached, show them right away, the input itself changes only with the reply
+  this->publish_input_source(source);
+  this->set_timeout("select_source", LINK_QUIET_TIME, [this]() { this->publish_input_source(this->input_source_); });
+}
+
+void AmplifierSerial::prefetch_source_state() {
+  // Only in the background, when nothing else is waiting for replies
+  if (!this->is_on() || this->prefetch_pending_ || this->has_pending_replies()) {
+    return;
+  }
+
+  Command command_code;
+  uint8_t source;
+  if (!this->source_states_.next_prefetch(command_code, source)) {
+    return;
+  }
+
+  this->prefetch_command_ = command_code;
+  this->prefetch_source_ = source;
+  bool sent = command_code == Command::PHONO_INPUT_TYPE
+                  ? this->send_command(command_code, STATUS_REQUEST)
+                  : this->send_command(command_code, {source, STATUS_REQUEST});
+  if (sent) {
+    this->prefetch_pending_ = true;
+    this->set_timeout("prefetch_timeout", LINK_QUIET_TIME, [this]() {
+      // No reply at all, treat it like an unsupported setting
+      this->prefetch_pending_ = false;
+      this->source_states_.store(this->prefetch_command_, this->prefetch_source_, VALUE_UNSUPPORTED);
+    });
+  } else {
+    // Unsupported by this model, mark it so the next query goes out
+    this->source_states_.store(command_code, source, VALUE_UNSUPPORTED);
+    this->defer("prefetch", [this]() { this->prefetch_source_state(); });
+  }
+}
+
+void AmplifierSerial::handle_source_setting(const ResponseFrame& frame, bool prefetch_reply) {
+  if (frame.data.empty()) {
+    return;
+  }
+
+  // Per input settings carry the input first, phono input type exists only for the phono input
+  uint8_t source = PHONO_SOURCE;
+  if (is_per_input_command(frame.command_code)) {
+    if (frame.data.size() < 2) {
+      ESP_LOGW(TAG, "%s reply without input, ignoring", command_to_string(frame.command_code));
+      if (prefetch_reply) {
+        // Asking again would get the same reply
+        this->source_states_.store(frame.command_code, this->prefetch_source_, VALUE_UNSUPPORTED);
+      }
+      return;
+    }
+    source = frame.data[0] & 0x0F;
+  }
+  uint8_t value = frame.data.back();
+
+  this->source_states_.store(frame.command_code, source, value);
+  if (source == this->input_source_) {
+    this->publish_source_state(source);
+  }
+}
+
+void AmplifierSerial::publish_input_source(uint8_t source) {
+  if (source == VALUE_UNKNOWN) {
+    return;
+  }
+  if (this->input_source_select_ != nullptr) {
+    this->input_source_select_->publish_state(source_to_string(source));
+  }
+  this->publish_source_state(source);
+}
+
+void AmplifierSerial::publish_source_state(uint8_t source) {
+  const SourceState& state = this->source_states_.get(source);
+  if (this->direct_mode_sensor_ != nullptr && state.direct_mode < VALUE_UNSUPPORTED) {
+    this->direct_mode_sensor_->publish_state(state.direct_mode == 0x01);
+  }
+  if (this->processor_mode_sensor_ != nullptr && state.processor_mode < VALUE_UNSUPPORTED) {
+    this->processor_mode_sensor_->publish_state(state.processor_mode == 0x01);
+  }
+  if (this->phono_input_type_sensor_ != nullptr && source == PHONO_SOURCE && state.phono_input_type < VALUE_UNSUPPORTED) {
+    this->phono_input_type_sensor_->publish_state(phono_input_type_to_string(state.phono_input_type));
+  }
+}
+
+bool AmplifierSerial::has_telemetry_sensors() const {
+  return this->lifter_temperature_.has_sensors() || this->output_temperature_.has_sensors() || this->overheat_sensor_ != nullptr ||
+         this->dc_offset_sensor_ != nullptr || this->short_circuit_sensor_ != nullptr;
+}
+
+void AmplifierSerial::sample_telemetry() {
+  if (!this->is_on()) {
+    this->telemetry_window_start_ = millis();
+    return;
+  }
+
+  // Only values something consumes, overheat is derived from both temperatures
+  if (this->lifter_temperature_.has_sensors() || this->overheat_sensor_ != nullptr) {
+    this->send_command(Command::LIFTER_TEMPERATURE, STATUS_REQUEST);
+  }
+  if (this->output_temperature_.has_sensors() || this->overheat_sensor_ != nullptr) {
+    this->send_command(Command::OUTPUT_TEMPERATURE, STATUS_REQUEST);
+  }
+  if (this->dc_offset_sensor_ != nullptr) {
+    this->send_command(Command::DC_OFFSET, STATUS_REQUEST);
+  }
+  if (this->short_circuit_sensor_ != nullptr) {
+    this->send_command(Command::SHORT_CIRCUIT_STATUS, STATUS_REQUEST);
+  }
+
+  // Samples of this tick arrive later and count towards the next window
+  if (millis() - this->telemetry_window_start_ >= this->telemetry_window_) {
+    this->telemetry_window_start_ = millis();
+    this->lifter_temperature_.publish_window();
+    this->output_temperature_.publish_window();
+  }
+}
+
+void AmplifierSerial::check_overheat() {
+  // fmax ignores a sensor that has no sample yet
+  float temperature = std::fmax(this->lifter_temperature_.last, this->output_temperature_.last);
+  if (std::isnan(temperature)) {
+    return;
+  }
+
+  // Hysteresis prevents flapping around the threshold
+  uint8_t overheat = this->overheat_;
+  if (temperature >= this->temperature_threshold_) {
+    overheat = 0x01;
+  } else if (temperature < this->temperature_threshold_ - TEMPERATURE_HYSTERESIS) {
+    overheat = 0x00;
+  } else if (overheat == 0xFF) {
+    overheat = 0x00;
+  }
+
+  if (overheat != this->overheat_) {
+    if (overheat) {
+      ESP_LOGW(TAG, "Temperature %.0f above threshold %.0f", temperature, this->temperature_threshold_);
+    }
+    this->publish_protection(this->overheat_sensor_, this->overheat_, overheat);
+  }
+}
+
+void AmplifierSerial::publish_protection(binary_sensor::BinarySensor *sensor, uint8_t &current, uint8_t value) {
+  if (value == current) {
+    return;
+  }
+  current = value;
+  if (sensor != nullptr) {
+    sensor->publish_state(value != 0x00);
+  }
+}
+
+void AmplifierSerial::handle_chunk(const ResponseFrame& frame, ChunkEvent event, const uint8_t *data, size_t length) {
+  size_t offset = this->chunk_offset_;
+  this->chunk_offset_ = event == ChunkEvent::DATA ? offset + length : 0;
+
+  if (event == ChunkEvent::ABORT) {
+    if (frame.command_code == Command::NOW_PLAYING_INFO) {
+      this->now_playing_.abort_store();
+    }
+    this->command_batch_.discard_data(frame.zone, frame.command_code);
+    return;
+  }
+
+  if (event == ChunkEvent::END) {
+    ESP_LOGD(TAG, "Received streamed frame: %s (%02X), Length: %d, Zone: %d",
+             command_to_string(frame.command_code), static_cast<uint8_t>(frame.command_code), frame.data_length, frame.zone);
+  }
+
+  // Chunks are handled as they arrive, text split across chunks is logged in parts
+  const char *text = reinterpret_cast<const char*>(data);
+  switch (frame.command_code) {
+    case Command::SERVICE_DATA:
+      if (offset == 0 && length >= 4) {
+        uint16_t f_type = data[0] | data[1] << 8;
+        uint16_t c_type = data[2] | data[3] << 8;
+        ESP_LOGD(TAG, "%04X %04X: %.*s", f_type, c_type, static_cast<int>(strnlen(text + 4, length - 4)), text + 4);
+      } else if (offset > 0) {
+        log_text_chunk("Service data", text, length);
+      }
+      break;
+
+    case Command::FRIENDLY_NAME:
+      log_text_chunk("Friendly name", text, length);
+      break;
+
+    case Command::NOW_PLAYING_INFO:
+      this->handle_now_playing(text, length, offset, event == ChunkEvent::END);
+      break;
+
+    case Command::ROOM_EQ_NAMES:
+      log_text_chunk(command_to_string(frame.command_code), text, length);
+      break;
+
+    default:
+      break;
+  }
+
+  if (event == ChunkEvent::DATA) {
+    this->command_batch_.append_data(frame.zone, frame.command_code, data, length);
+  } else if (this->command_batch_.handle_reply(frame.zone, frame.command_code, frame.answer_code, data, length)) {
+    this->finish_command_batch();
+  }
+}
+
+bool AmplifierSerial::has_now_playing_sensors() const {
+  return this->title_sensor_ != nullptr || this->artist_sensor_ != nullptr || this->album_sensor_ != nullptr ||
+         this->audio_encoder_sensor_ != nullptr || this->audio_sample_rate_sensor_ != nullptr;
+}
+
+void AmplifierSerial::fetch_now_playing() {
+  if (this->input_source_ != NET_USB_SOURCE) {
+    return;  // Stale fields are fetched after switching to the network input
+  }
+  NowPlayingField field;
+  if (this->now_playing_.next_request(field)) {
+    if (!this->send_command(Command::NOW_PLAYING_INFO, static_cast<uint8_t>(field))) {
+      this->now_playing_.clear();  // Not supported by this model, don't try again
+      return;
+    }
+    this->set_timeout("now_playing", NOW_PLAYING_TIMEOUT, [this]() {
+      this->now_playing_.requeue_pending();
+      this->fetch_now_playing();
+    });
+  }
+}
+
+void AmplifierSerial::clear_now_playing() {
+  this->cancel_timeout("now_playing");
+  this->now_playing_.clear();
+  for (auto *sensor : {this->title_sensor_, this->artist_sensor_, this->album_sensor_, this->audio_encoder_sensor_}) {
+    if (sensor != nullptr) {
+      sensor->publish_state("");
+    }
+  }
+}
+
+void AmplifierSerial::handle_now_playing(const char *text, size_t length, size_t offset, bool last) {
+  NowPlayingField field;
+  if (!this->now_playing_.get_pending(field)) {
+    if (last) {
+      ESP_LOGW(TAG, "Unexpected now playing info, ignoring");
+    }
+    return;
+  }
+
+  if (field != NowPlayingField::ENCODER) {
+    this->now_playing_.append(text, length);
+  } else if (offset == 0 && length >= 1) {
+    // Encoder is reported as a code, cache its name so it's compared and published like other fields
+    const char *name = audio_encoder_to_string(text[0]);
+    this->now_playing_.append(name, strlen(name));
+  }
+  if (!last) {
+    return;
+  }
+
+  this->cancel_timeout("now_playing");
+  if (this->now_playing_.commit()) {
+    ESP_LOGD(TAG, "Now playing %s: %s", now_playing_field_to_string(field), this->now_playing_.get(field));
+    text_sensor::TextSensor *sensor = nullptr;
+    switch (field) {
+      case NowPlayingField::TITLE:
+        sensor = this->title_sensor_;
+        // New track, the rest of the track info has to be refreshed too
+        this->now_playing_.invalidate(NowPlayingField::ARTIST);
+        this->now_playing_.invalidate(NowPlayingField::ALBUM);
+        break;
+      case NowPlayingField::ARTIST:
+        sensor = this->artist_sensor_;
+        break;
+      case NowPlayingField::ALBUM:
+        sensor = this->album_sensor_;
+        break;
+      case NowPlayingField::ENCODER:
+        sensor = this->audio_encoder_sensor_;
+        break;
+    }
+    if (sensor != nullptr) {
+      sensor->publish_state(this->now_playing_.get(field));
+    }
+  }
+
+  this->fetch_now_playing();
+}
+
 void AmplifierSerial::control(const media_player::MediaPlayerCall &call) {
   if (call.get_volume().has_value()) {
     float volume = *call.get_volume();
@@ -244,7 +835,10 @@ media_player::MediaPlayerTraits AmplifierSerial::get_traits() {
 void AmplifierSerial::on_turn_on() {
   if (this->state_ == State::UNAVAILABLE) {
     ESP_LOGD(TAG, "Turning amplifier on");
+    this->turn_on_time_ = millis();
     this->send_command(Command::POWER, 0x01);
+    // Unit didn't react, a later power on from the front panel must not be taken as ours
+    this->set_timeout("turn_on", INIT_TIME, [this]() { this->turn_on_time_ = 0; });
   }
 }
 
@@ -255,6 +849,207 @@ void AmplifierSerial::on_turn_off() {
   }
 }
 
+void AmplifierSerial::add_preset_setting(const std::string& preset, Command command_code, uint8_t value) {
+  auto it = std::find_if(this->presets_.begin(), this->presets_.end(), [&preset](const Preset& p) { return p.name == preset; });
+  if (it == this->presets_.end()) {
+    this->presets_.push_back(Preset{.name = preset, .settings = {}});
+    it = this->presets_.end() - 1;
+  }
+  it->settings.push_back(PresetSetting{.command_code = command_code, .value = value});
+}
+
+void AmplifierSerial::on_apply_preset(std::string preset) {
+  auto it = std::find_if(this->presets_.begin(), this->presets_.end(), [&preset](const Preset& p) { return p.name == preset; });
+  if (it == this->presets_.end()) {
+    ESP_LOGW(TAG, "Unknown preset: %s", preset.c_str());
+    return;
+  }
+  if (!this->is_on()) {
+    ESP_LOGW(TAG, "Cannot apply preset %s, amplifier is not on", preset.c_str());
+    return;
+  }
+  if (this->preset_transaction_.is_active()) {
+    ESP_LOGW(TAG, "Preset %s superseded by %s", this->preset_transaction_.name().c_str(), preset.c_str());
+    this->preset_transaction_.replies().abort();
+    this->finish_preset();
+  }
+
+  auto changes = this->preset_transaction_.begin(*it, this->settings_, this->source_states_);
+  ESP_LOGD(TAG, "Applying preset %s: %u of %u settings changed", preset.c_str(),
+           static_cast<unsigned>(changes.size()), static_cast<unsigned>(it->settings.size()));
+  this->send_pending(this->preset_transaction_.replies(), changes, "preset", PRESET_TIMEOUT, [this]() { this->finish_preset(); });
+}
+
+void AmplifierSerial::finish_preset() {
+  this->cancel_timeout("preset");
+  bool success = this->preset_transaction_.is_successful();
+  ESP_LOGI(TAG, "Preset %s %s", this->preset_transaction_.name().c_str(), success ? "applied" : "failed");
+  this->fire_homeassistant_event("esphome.amplifier_preset", {{"preset", this->preset_transaction_.name()}, {"success", success ? "true" : "false"}});
+  this->preset_transaction_.reset();
+}
+
+void AmplifierSerial::on_send_commands(std::vector<std::string> commands) {
+  // Each command is hex encoded zone, command code and data, e.g. "010DF0" requests volume of zone 1
+  std::vector<RequestFrame> requests;
+  requests.reserve(commands.size());
+  for (const auto& command : commands) {
+    // At least zone and command code, two hex digits per byte
+    std::vector<uint8_t> bytes;
+    if (command.size() < 4 || command.size() % 2 != 0 || !parse_hex(command, bytes, command.size() / 2)) {
+      ESP_LOGW(TAG, "Invalid command: %s, batch not sent", command.c_str());
+      return;
+    }
+    requests.push_back(RequestFrame{
+      .zone = bytes[0],
+      .command_code = static_cast<Command>(bytes[1]),
+      .data = std::vector<uint8_t>(bytes.begin() + 2, bytes.end())
+    });
+  }
+
+  if (this->command_batch_.is_active()) {
+    ESP_LOGW(TAG, "Previous command batch superseded");
+    this->finish_command_batch();
+  }
+
+  this->send_pending(this->command_batch_, requests, "commands", COMMAND_BATCH_TIMEOUT, [this]() { this->finish_command_batch(); });
+}
+
+void AmplifierSerial::send_pending(PendingReplies& pending, const std::vector<RequestFrame>& requests, const std::string& timeout_name,
+                                   uint32_t timeout, std::function<void()> finish) {
+  pending.begin();
+  for (const auto& request : requests) {
+    pending.add(request.zone, request.command_code);
+  }
+  // Send everything at once, replies are matched to the requests as they arrive
+  for (size_t i = 0; i < requests.size(); i++) {
+    if (!this->send_command(requests[i].command_code, requests[i].data, requests[i].zone)) {
+      pending.reject(i, Answer::COMMAND_INVALID);
+    }
+  }
+
+  if (pending.is_complete()) {
+    finish();
+    return;
+  }
+  this->set_timeout(timeout_name, timeout, [this, &pending, timeout_name, finish]() {
+    ESP_LOGW(TAG, "No reply to %u of %u commands (%s)", static_cast<unsigned>(pending.pending()),
+             static_cast<unsigned>(pending.replies().size()), timeout_name.c_str());
+    pending.abort();
+    finish();
+  });
+}
+
+void AmplifierSerial::finish_command_batch() {
+  this->cancel_timeout("commands");
+  std::string results = this->command_batch_.to_string();
+  bool success = this->command_batch_.is_successful();
+  ESP_LOGD(TAG, "Command batch %s: %s", success ? "completed" : "failed", results.c_str());
+  this->fire_homeassistant_event("esphome.amplifier_commands", {{"results", results}, {"success", success ? "true" : "false"}});
+  this->command_batch_.reset();
+}
+
+void AmplifierSerial::add_ir_macro_step(const std::string& macro, uint8_t system, uint8_t command, uint32_t delay_ms) {
+  auto it = std::find_if(this->ir_macros_.begin(), this->ir_macros_.end(), [&macro](const IrMacro& m) { return m.name == macro; });
+  if (it == this->ir_macros_.end()) {
+    this->ir_macros_.push_back(IrMacro{.name = macro, .steps = {}});
+    it = this->ir_macros_.end() - 1;
+  }
+  it->steps.push_back(IrStep{.system = system, .command = command, .delay_ms = delay_ms});
+}
+
+void AmplifierSerial::on_run_ir_macro(std::string macro) {
+  auto it = std::find_if(this->ir_macros_.begin(), this->ir_macros_.end(), [&macro](const IrMacro& m) { return m.name == macro; });
+  if (it == this->ir_macros_.end()) {
+    ESP_LOGW(TAG, "Unknown IR macro: %s", macro.c_str());
+    return;
+  }
+  ESP_LOGD(TAG, "Running IR macro %s", macro.c_str());
+  if (this->ir_macro_runner_.is_running()) {
+    ESP_LOGW(TAG, "IR macro %s superseded by %s", this->ir_macro_runner_.name().c_str(), macro.c_str());
+    this->finish_ir_macro(false);
+  }
+  this->ir_macro_runner_.start(it->name, it->steps);
+  this->send_ir_step();
+}
+
+void AmplifierSerial::on_send_ir_codes(std::vector<int32_t> codes) {
+  // Codes are given as RC5 system code in the high byte and command in the low byte
+  std::vector<IrStep> steps;
+  steps.reserve(codes.size());
+  for (auto code : codes) {
+    if (code < 0 || code > 0xFFFF) {
+      ESP_LOGW(TAG, "Invalid IR code: %d, codes not sent", static_cast<int>(code));
+      return;
+    }
+    steps.push_back(IrStep{.system = static_cast<uint8_t>(code >> 8), .command = static_cast<uint8_t>(code), .delay_ms = IR_DEFAULT_DELAY});
+  }
+  if (this->ir_macro_runner_.is_running()) {
+    ESP_LOGW(TAG, "IR macro %s superseded by IR codes", this->ir_macro_runner_.name().c_str());
+    this->finish_ir_macro(false);
+  }
+  this->ir_macro_runner_.start("service", steps);
+  this->send_ir_step();
+}
+
+void AmplifierSerial::on_cancel_ir_macro() {
+  if (this->ir_macro_runner_.is_running()) {
+    ESP_LOGD(TAG, "IR macro %s cancelled", this->ir_macro_runner_.name().c_str());
+    this->finish_ir_macro(false);
+  }
+}
+
+void AmplifierSerial::send_ir_step() {
+  const IrStep *step = this->ir_macro_runner_.send_step();
+  if (step == nullptr) {
+    this->finish_ir_macro(true);
+    return;
+  }
+  if (!this->send_command(Command::IR_COMMAND, {step->system, step->command})) {
+    this->finish_ir_macro(false);
+    return;
+  }
+  this->set_timeout("ir_macro", IR_ACK_TIMEOUT, [this]() {
+    // The key may have been taken even without a reply, sending it again could press it twice
+    ESP_LOGW(TAG, "IR macro %s: key not acknowledged", this->ir_macro_runner_.name().c_str());
+    this->finish_ir_macro(false);
+  });
+}
+
+void AmplifierSerial::handle_ir_ack(const ResponseFrame& frame) {
+  this->cancel_timeout("ir_macro");
+  if (frame.answer_code == Answer::STATUS_UPDATE) {
+    this->ir_macro_runner_.acknowledge();
+    this->set_timeout("ir_macro", this->ir_macro_runner_.last_step().delay_ms, [this]() { this->send_ir_step(); });
+  } else if (frame.answer_code == Answer::COMMAND_INVALID_TMP && this->ir_macro_runner_.retry()) {
+    // Unit is busy, e.g. still switching inputs, send the same key again a bit later
+    this->set_timeout("ir_macro", IR_RETRY_DELAY, [this]() { this->send_ir_step(); });
+  } else {
+    this->finish_ir_macro(false);
+  }
+}
+
+void AmplifierSerial::finish_ir_macro(bool success) {
+  this->cancel_timeout("ir_macro");
+  const std::string& name = this->ir_macro_runner_.name();
+  if (success) {
+    ESP_LOGD(TAG, "IR macro %s finished", name.c_str());
+  } else {
+    ESP_LOGW(TAG, "IR macro %s aborted", name.c_str());
+  }
+  this->fire_homeassistant_event("esphome.amplifier_ir_macro", {{"macro", name}, {"success", success ? "true" : "false"}});
+  this->ir_macro_runner_.cancel();
+}
+
+void InputSourceSelect::control(const std::string &value) {
+  for (auto source : INPUT_SOURCES) {
+    if (value == source_to_string(source)) {
+      this->parent_->select_source(source);
+      return;
+    }
+  }
+  ESP_LOGW(TAG, "Unknown input source: %s", value.c_str());
+}
+
 
 const char* state_to_string(State state) {
   switch (state) {
@@ -1,14 +1,24 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <string>
 
 #include "esphome/components/api/custom_api_device.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
 #include "esphome/components/media_player/media_player.h"
+#include "esphome/components/select/select.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/text_sensor/text_sensor.h"
 #include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "ir_macro.h"
+#include "now_playing.h"
+#include "pending_replies.h"
+#include "preset.h"
 #include "protocol.h"
+#include "source_state.h"
+#include "telemetry.h"
 #include "transport.h"
 #include "units.h"
 
@@ -16,6 +26,10 @@ namespace esphome {
 namespace amplifier_serial {
 
 const uint32_t POLLING_TIME = 15000;
+// About 4 bytes per ms arrive at 38400 baud, so while the loop sleeps the UART buffer has to hold
+// what arrives during the poll interval plus the loop latency. The longest frame is 260 bytes.
+const uint32_t IDLE_RX_POLL_INTERVAL = 20;
+const size_t MIN_RX_BUFFER_SIZE = 512;
 
 enum class State {
   UNDEFINED,
@@ -26,6 +40,8 @@ enum class State {
   PLAYING,
 };
 
+class InputSourceSelect;
+
 class AmplifierSerial : public SerialTransport, 
                         public media_player::MediaPlayer,
                         public api::CustomAPIDevice,
@@ -45,10 +61,36 @@ public:
   void control(const media_player::MediaPlayerCall &call) override;
   bool is_muted() const override { return this->muted_; }
   bool is_on() const { return this->state_ >= State::IDLE; }
+  void select_source(uint8_t source);
 
   void set_software_version_sensor(text_sensor::TextSensor *sensor) { this->software_version_sensor_ = sensor; }
   void set_max_volume_sensor(sensor::Sensor *sensor) { this->max_volume_sensor_ = sensor; }
   void set_max_streaming_volume_sensor(sensor::Sensor *sensor) { this->max_streaming_volume_sensor_ = sensor; }
+  void set_lifter_temperature_average_sensor(sensor::Sensor *sensor) { this->lifter_temperature_.average_sensor = sensor; }
+  void set_lifter_temperature_min_sensor(sensor::Sensor *sensor) { this->lifter_temperature_.min_sensor = sensor; }
+  void set_lifter_temperature_max_sensor(sensor::Sensor *sensor) { this->lifter_temperature_.max_sensor = sensor; }
+  void set_output_temperature_average_sensor(sensor::Sensor *sensor) { this->output_temperature_.average_sensor = sensor; }
+  void set_output_temperature_min_sensor(sensor::Sensor *sensor) { this->output_temperature_.min_sensor = sensor; }
+  void set_output_temperature_max_sensor(sensor::Sensor *sensor) { this->output_temperature_.max_sensor = sensor; }
+  void set_overheat_sensor(binary_sensor::BinarySensor *sensor) { this->overheat_sensor_ = sensor; }
+  void set_dc_offset_sensor(binary_sensor::BinarySensor *sensor) { this->dc_offset_sensor_ = sensor; }
+  void set_short_circuit_sensor(binary_sensor::BinarySensor *sensor) { this->short_circuit_sensor_ = sensor; }
+  void set_telemetry_interval(uint32_t interval) { this->telemetry_interval_ = interval; }
+  void set_telemetry_window(uint32_t window) { this->telemetry_window_ = window; }
+  void set_temperature_threshold(float threshold) { this->temperature_threshold_ = threshold; }
+
+  void add_preset_setting(const std::string& preset, Command command_code, uint8_t value);
+  void add_ir_macro_step(const std::string& macro, uint8_t system, uint8_t command, uint32_t delay_ms);
+
+  void set_input_source_select(InputSourceSelect *select) { this->input_source_select_ = select; }
+  void set_direct_mode_sensor(binary_sensor::BinarySensor *sensor) { this->direct_mode_sensor_ = sensor; }
+  void set_processor_mode_sensor(binary_sensor::BinarySensor *sensor) { this->processor_mode_sensor_ = sensor; }
+  void set_phono_input_type_sensor(text_sensor::TextSensor *sensor) { this->phono_input_type_sensor_ = sensor; }
+  void set_title_sensor(text_sensor::TextSensor *sensor) { this->title_sensor_ = sensor; }
+  void set_artist_sensor(text_sensor::TextSensor *sensor) { this->artist_sensor_ = sensor; }
+  void set_album_sensor(text_sensor::TextSensor *sensor) { this->album_sensor_ = sensor; }
+  void set_audio_encoder_sensor(text_sensor::TextSensor *sensor) { this->audio_encoder_sensor_ = sensor; }
+  void set_audio_sample_rate_sensor(text_sensor::TextSensor *sensor) { this->audio_sample_rate_sensor_ = sensor; }
 
 protected:
   State state_ = State::UNDEFINED;
@@ -56,16 +98,109 @@ protected:
   bool muted_ = false;
   uint32_t standby_timeout_ms_ = 20 * units::MINUTE;
   uint32_t last_active_time_ = 0;
+  bool loop_sleeping_ = false;
+  uint32_t turn_on_time_ = 0;  // Non-zero while a turn on requested by us is in progress
+  uint32_t power_on_time_ = 0;
+  uint8_t init_pending_ = 0;   // Bit per initialization query not yet answered
+  uint8_t system_status_retries_ = 0;
 
   text_sensor::TextSensor *software_version_sensor_{nullptr};
+  text_sensor::TextSensor *title_sensor_{nullptr};
+  text_sensor::TextSensor *artist_sensor_{nullptr};
+  text_sensor::TextSensor *album_sensor_{nullptr};
+  text_sensor::TextSensor *audio_encoder_sensor_{nullptr};
+  text_sensor::TextSensor *audio_sample_rate_sensor_{nullptr};
 
   sensor::Sensor *max_volume_sensor_{nullptr};
   sensor::Sensor *max_streaming_volume_sensor_{nullptr};
 
+  InputSourceSelect *input_source_select_{nullptr};
+  binary_sensor::BinarySensor *direct_mode_sensor_{nullptr};
+  binary_sensor::BinarySensor *processor_mode_sensor_{nullptr};
+  text_sensor::TextSensor *phono_input_type_sensor_{nullptr};
+
+  uint8_t input_source_ = VALUE_UNKNOWN;
+  SourceStateTable source_states_;
+  bool prefetch_pending_ = false;
+  Command prefetch_command_ = Command::DIRECT_MODE;
+  uint8_t prefetch_source_ = 0;
+
+  binary_sensor::BinarySensor *overheat_sensor_{nullptr};
+  binary_sensor::BinarySensor *dc_offset_sensor_{nullptr};
+  binary_sensor::BinarySensor *short_circuit_sensor_{nullptr};
+
+  TemperatureTelemetry lifter_temperature_;
+  TemperatureTelemetry output_temperature_;
+  uint32_t telemetry_interval_ = TELEMETRY_INTERVAL;
+  uint32_t telemetry_window_ = TELEMETRY_WINDOW;
+  uint32_t telemetry_window_start_ = 0;
+  float temperature_threshold_ = TEMPERATURE_THRESHOLD;
+  uint8_t overheat_ = 0xFF;       // Unknown until first sample
+  uint8_t dc_offset_ = 0xFF;      // Unknown until first reply
+  uint8_t short_circuit_ = 0xFF;  // Unknown until first reply
+
+  size_t chunk_offset_ = 0;  // Position of the next streamed chunk within its frame payload
+
+  SettingsCache settings_;
+  std::vector<Preset> presets_;
+  PresetTransaction preset_transaction_;
+
+  PendingReplies command_batch_;
+
+  std::vector<IrMacro> ir_macros_;
+  IrMacroRunner ir_macro_runner_;
+
+  NowPlayingCache now_playing_;
+  uint8_t network_playback_ = 0xFF;   // Unknown until first reply
+  uint8_t audio_sample_rate_ = 0xFF;  // Unknown until first reply
+
+  void start_initialization();
+  void send_init_queries();
+  void handle_init_reply(const ResponseFrame& frame);
+  void finish_init_queries();
+  void send_system_status();
+  void retry_system_status();
+
+  void on_send() override { this->wake_loop(); }
+  bool has_pending_replies() const;
+  void sleep_loop();
+  void wake_loop();
+
   void handle_frame(const ResponseFrame& frame);
+  void handle_chunk(const ResponseFrame& frame, ChunkEvent event, const uint8_t *data, size_t length);
+  bool has_now_playing_sensors() const;
+  void fetch_now_playing();
+  void clear_now_playing();
+  void handle_now_playing(const char *text, size_t length, size_t offset, bool last);
+
+  void prefetch_source_state();
+  void handle_source_setting(const ResponseFrame& frame, bool prefetch_reply);
+  void publish_input_source(uint8_t source);
+  void publish_source_state(uint8_t source);
+  bool has_telemetry_sensors() const;
+  void sample_telemetry();
+  void check_overheat();
+  void publish_protection(binary_sensor::BinarySensor *sensor, uint8_t &current, uint8_t value);
+  void send_pending(PendingReplies& pending, const std::vector<RequestFrame>& requests, const std::string& timeout_name,
+                    uint32_t timeout, std::function<void()> finish);
+  void finish_preset();
+  void finish_command_batch();
+  void send_ir_step();
+  void handle_ir_ack(const ResponseFrame& frame);
+  void finish_ir_macro(bool success);
 
   void on_turn_on();
   void on_turn_off();
+  void on_apply_preset(std::string preset);
+  void on_send_commands(std::vector<std::string> commands);
+  void on_run_ir_macro(std::string macro);
+  void on_send_ir_codes(std::vector<int32_t> codes);
+  void on_cancel_ir_macro();
+};
+
+class InputSourceSelect : public select::Select, public Parented<AmplifierSerial> {
+protected:
+  void control(const std::string &value) override;
 };
 
 const char* state_to_string(State state);
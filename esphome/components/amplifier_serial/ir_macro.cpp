@@ -0,0 +1,48 @@
+#include "esphome/core/log.h"
+#include "ir_macro.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+static const char *TAG = "amplifier_serial.ir_macro";
+
+void IrMacroRunner::start(const std::string& name, const std::vector<IrStep>& steps) {
+  this->running_ = !steps.empty();
+  this->awaiting_ack_ = false;
+  this->index_ = 0;
+  this->retries_ = 0;
+  this->name_ = name;
+  this->steps_ = steps;
+}
+
+void IrMacroRunner::cancel() {
+  this->running_ = false;
+  this->awaiting_ack_ = false;
+  this->steps_.clear();
+}
+
+const IrStep *IrMacroRunner::send_step() {
+  if (!this->running_ || this->index_ >= this->steps_.size()) {
+    this->running_ = false;
+    return nullptr;
+  }
+  this->awaiting_ack_ = true;
+  return &this->steps_[this->index_];
+}
+
+bool IrMacroRunner::is_ack(const ResponseFrame& frame) const {
+  return this->awaiting_ack_ && frame.command_code == Command::IR_COMMAND;
+}
+
+bool IrMacroRunner::retry() {
+  this->awaiting_ack_ = false;
+  if (++this->retries_ > IR_MAX_RETRIES) {
+    ESP_LOGW(TAG, "IR macro %s: step %u still rejected after %d retries", this->name_.c_str(),
+             static_cast<unsigned>(this->index_ + 1), IR_MAX_RETRIES);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace amplifier_serial
+}  // namespace esphome
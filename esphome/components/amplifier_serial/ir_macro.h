@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+#include "units.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+const uint32_t IR_ACK_TIMEOUT = 1 * units::SECOND;
+const uint32_t IR_DEFAULT_DELAY = 300;  // Menus drop keypresses sent faster than the display updates
+const uint32_t IR_RETRY_DELAY = 500;  // Keys are repeated only when the unit reported it was busy
+const uint8_t IR_MAX_RETRIES = 3;
+
+struct IrStep {
+  uint8_t system;
+  uint8_t command;
+  uint32_t delay_ms;  // Pause after the key was acknowledged
+};
+
+struct IrMacro {
+  std::string name;
+  std::vector<IrStep> steps;
+};
+
+// Tracks progress of a key sequence, each key is sent only after the previous one was acknowledged
+class IrMacroRunner {
+public:
+  void start(const std::string& name, const std::vector<IrStep>& steps);
+  void cancel();
+
+  // Step to be sent next, nullptr when the macro is finished
+  const IrStep *send_step();
+  // Returns true if the frame is the acknowledgment the runner was waiting for
+  bool is_ack(const ResponseFrame& frame) const;
+  void acknowledge() { awaiting_ack_ = false; index_++; retries_ = 0; }
+  // Unit was busy and didn't take the key, returns false when the step should not be retried anymore
+  bool retry();
+
+  bool is_running() const { return running_; }
+  bool is_awaiting_ack() const { return awaiting_ack_; }
+  const std::string& name() const { return name_; }
+  const IrStep& last_step() const { return steps_[index_ - 1]; }
+
+private:
+  bool running_ = false;
+  bool awaiting_ack_ = false;
+  size_t index_ = 0;
+  uint8_t retries_ = 0;
+  std::string name_;
+  std::vector<IrStep> steps_;
+};
+
+}  // namespace amplifier_serial
+}  // namespace esphome
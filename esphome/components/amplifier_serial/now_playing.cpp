@@ -0,0 +1,139 @@
+#include <cstring>
+#include "esphome/core/log.h"
+#include "now_playing.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+static const char *TAG = "amplifier_serial.now_playing";
+
+static size_t field_index(NowPlayingField field) {
+  for (size_t i = 0; i < NOW_PLAYING_FIELD_COUNT; i++) {
+    if (NOW_PLAYING_FIELDS[i] == field) {
+      return i;
+    }
+  }
+  return NOW_PLAYING_FIELD_COUNT;
+}
+
+NowPlayingCache::NowPlayingCache() {
+  this->clear();
+}
+
+void NowPlayingCache::invalidate(NowPlayingField field) {
+  this->stale_ |= 1 << field_index(field);
+}
+
+void NowPlayingCache::invalidate_track() {
+  this->invalidate(NowPlayingField::TITLE);
+  this->invalidate(NowPlayingField::ARTIST);
+  this->invalidate(NowPlayingField::ALBUM);
+}
+
+void NowPlayingCache::invalidate_format() {
+  this->invalidate(NowPlayingField::ENCODER);
+}
+
+void NowPlayingCache::clear() {
+  memset(this->arena_, 0, sizeof(this->arena_));
+  this->stale_ = 0;
+  this->cancel_pending();
+}
+
+bool NowPlayingCache::next_request(NowPlayingField &field) {
+  if (this->pending_ < NOW_PLAYING_FIELD_COUNT) {
+    return false;
+  }
+  for (size_t i = 0; i < NOW_PLAYING_FIELD_COUNT; i++) {
+    if (this->stale_ & (1 << i)) {
+      this->stale_ &= ~(1 << i);
+      this->pending_ = i;
+      this->write_pos_ = 0;
+      this->write_changed_ = false;
+      this->write_done_ = false;
+      field = NOW_PLAYING_FIELDS[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+bool NowPlayingCache::get_pending(NowPlayingField &field) const {
+  if (this->pending_ >= NOW_PLAYING_FIELD_COUNT) {
+    return false;
+  }
+  field = NOW_PLAYING_FIELDS[this->pending_];
+  return true;
+}
+
+void NowPlayingCache::requeue_pending() {
+  if (this->pending_ < NOW_PLAYING_FIELD_COUNT) {
+    this->stale_ |= 1 << this->pending_;
+  }
+  this->cancel_pending();
+}
+
+void NowPlayingCache::append(const char *text, size_t length) {
+  if (this->pending_ >= NOW_PLAYING_FIELD_COUNT) {
+    return;
+  }
+
+  char *slot = this->arena_[this->pending_];
+  for (size_t i = 0; i < length && !this->write_done_; i++) {
+    if (text[i] == '\0' || this->write_pos_ >= NOW_PLAYING_TEXT_SIZE - 1) {
+      this->write_done_ = true;
+      break;
+    }
+    if (slot[this->write_pos_] != text[i]) {
+      slot[this->write_pos_] = text[i];
+      this->write_changed_ = true;
+    }
+    this->write_pos_++;
+  }
+}
+
+bool NowPlayingCache::commit() {
+  if (this->pending_ >= NOW_PLAYING_FIELD_COUNT) {
+    ESP_LOGW(TAG, "Unexpected now playing info, ignoring");
+    return false;
+  }
+
+  char *slot = this->arena_[this->pending_];
+  if (slot[this->write_pos_] != '\0') {
+    slot[this->write_pos_] = '\0';
+    this->write_changed_ = true;
+  }
+  this->cancel_pending();
+  return this->write_changed_;
+}
+
+void NowPlayingCache::abort_store() {
+  if (this->pending_ >= NOW_PLAYING_FIELD_COUNT) {
+    return;
+  }
+  this->arena_[this->pending_][0] = '\0';
+  this->stale_ |= 1 << this->pending_;
+  this->cancel_pending();
+}
+
+const char *NowPlayingCache::get(NowPlayingField field) const {
+  return this->arena_[field_index(field)];
+}
+
+const char* now_playing_field_to_string(NowPlayingField field) {
+  switch (field) {
+    case NowPlayingField::TITLE:
+      return "Title";
+    case NowPlayingField::ARTIST:
+      return "Artist";
+    case NowPlayingField::ALBUM:
+      return "Album";
+    case NowPlayingField::ENCODER:
+      return "Encoder";
+    default:
+      return "Unknown field";
+  }
+}
+
+}  // namespace amplifier_serial
+}  // namespace esphome
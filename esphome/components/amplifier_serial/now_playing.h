@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "units.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+const size_t NOW_PLAYING_TEXT_SIZE = 64;  // Longer texts are truncated, HA shows only the beginning anyway
+// Replies don't say which field they carry, a request is given up only when its reply can't be expected anymore
+const uint32_t NOW_PLAYING_TIMEOUT = 2 * units::SECOND;
+
+// Request codes of the Now Playing Info command, only fields we publish are fetched
+enum class NowPlayingField : uint8_t {
+  TITLE       = 0xF0,
+  ARTIST      = 0xF1,
+  ALBUM       = 0xF2,
+  ENCODER     = 0xF5,  // Sample rate is taken from Audio Sample Rate, which works for all inputs
+};
+
+const NowPlayingField NOW_PLAYING_FIELDS[] = {
+  NowPlayingField::TITLE,
+  NowPlayingField::ARTIST,
+  NowPlayingField::ALBUM,
+  NowPlayingField::ENCODER,
+};
+const size_t NOW_PLAYING_FIELD_COUNT = sizeof(NOW_PLAYING_FIELDS) / sizeof(NOW_PLAYING_FIELDS[0]);
+
+// Keeps now playing metadata in a fixed arena and tracks which fields have to be fetched again.
+// Fields are requested one at a time, replies of Now Playing Info don't say which field they carry.
+class NowPlayingCache {
+public:
+  NowPlayingCache();
+
+  void invalidate(NowPlayingField field);
+  void invalidate_track();   // Title, artist and album
+  void invalidate_format();  // Encoder
+  void clear();
+
+  // Picks the next stale field to request, returns false if nothing to fetch or a request is pending
+  bool next_request(NowPlayingField &field);
+  bool get_pending(NowPlayingField &field) const;
+  void cancel_pending() { pending_ = NOW_PLAYING_FIELD_COUNT; }
+  // Gives up waiting for a timed out reply, the field is fetched again with the next request
+  void requeue_pending();
+
+  // Reply to the pending request is written into its slot as chunks arrive, comparing on the way
+  void append(const char *text, size_t length);
+  // Finishes the reply, returns true if the cached value changed
+  bool commit();
+  // Reply broke off, slot content is lost and the field has to be fetched again
+  void abort_store();
+  const char *get(NowPlayingField field) const;
+
+private:
+  char arena_[NOW_PLAYING_FIELD_COUNT][NOW_PLAYING_TEXT_SIZE];
+  uint8_t stale_ = 0;  // Bit per field index
+  size_t pending_ = NOW_PLAYING_FIELD_COUNT;
+  size_t write_pos_ = 0;
+  bool write_changed_ = false;
+  bool write_done_ = false;  // Terminator seen or slot full, rest of the reply is ignored
+};
+
+const char* now_playing_field_to_string(NowPlayingField field);
+
+}  // namespace amplifier_serial
+}  // namespace esphome
@@ -0,0 +1,107 @@
+#include "esphome/core/log.h"
+#include "pending_replies.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+static const char *TAG = "amplifier_serial.pending_replies";
+
+void PendingReplies::begin() {
+  this->active_ = true;
+  this->pending_ = 0;
+  this->replies_.clear();
+}
+
+void PendingReplies::add(uint8_t zone, Command command_code) {
+  this->replies_.push_back(PendingReply{
+    .zone = zone,
+    .command_code = command_code,
+    .answered = false,
+    .answer_code = Answer::STATUS_UPDATE,
+    .data = {}
+  });
+  this->pending_++;
+}
+
+void PendingReplies::reject(size_t index, Answer answer_code) {
+  auto& reply = this->replies_[index];
+  if (!reply.answered) {
+    reply.answered = true;
+    reply.answer_code = answer_code;
+    this->pending_--;
+  }
+}
+
+PendingReply *PendingReplies::find_pending(uint8_t zone, Command command_code) {
+  if (!this->active_ || this->pending_ == 0) {
+    return nullptr;
+  }
+
+  // First unanswered request of the command, replies come in the order of requests
+  for (auto& reply : this->replies_) {
+    if (!reply.answered && reply.zone == zone && reply.command_code == command_code) {
+      return &reply;
+    }
+  }
+  return nullptr;
+}
+
+void PendingReplies::append_data(uint8_t zone, Command command_code, const uint8_t *data, size_t length) {
+  auto *reply = this->find_pending(zone, command_code);
+  if (reply != nullptr) {
+    reply->data.insert(reply->data.end(), data, data + length);
+  }
+}
+
+void PendingReplies::discard_data(uint8_t zone, Command command_code) {
+  auto *reply = this->find_pending(zone, command_code);
+  if (reply != nullptr) {
+    reply->data.clear();
+  }
+}
+
+bool PendingReplies::handle_reply(uint8_t zone, Command command_code, Answer answer_code, const uint8_t *data, size_t length) {
+  auto *reply = this->find_pending(zone, command_code);
+  if (reply == nullptr) {
+    return false;
+  }
+
+  reply->answered = true;
+  reply->answer_code = answer_code;
+  reply->data.insert(reply->data.end(), data, data + length);
+  this->pending_--;
+  ESP_LOGV(TAG, "%s answered, %u pending", command_to_string(command_code), static_cast<unsigned>(this->pending_));
+  return this->pending_ == 0;
+}
+
+void PendingReplies::reset() {
+  this->active_ = false;
+  this->pending_ = 0;
+  this->replies_.clear();
+}
+
+bool PendingReplies::is_successful() const {
+  for (const auto& reply : this->replies_) {
+    if (!reply.answered || reply.answer_code != Answer::STATUS_UPDATE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string PendingReplies::to_string() const {
+  std::string out;
+  for (const auto& reply : this->replies_) {
+    if (!out.empty()) {
+      out += ',';
+    }
+    std::vector<uint8_t> header{reply.zone, static_cast<uint8_t>(reply.command_code)};
+    out += to_hex_string(header);
+    // Unanswered requests have no answer code
+    out += reply.answered ? to_hex_string({static_cast<uint8_t>(reply.answer_code)}) + ":" + to_hex_string(reply.data) : "--";
+  }
+  return out;
+}
+
+}  // namespace amplifier_serial
+}  // namespace esphome
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+#include "units.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+const uint32_t COMMAND_BATCH_TIMEOUT = 5 * units::SECOND;
+
+struct PendingReply {
+  uint8_t zone;
+  Command command_code;
+  bool answered;
+  Answer answer_code;
+  std::vector<uint8_t> data;
+};
+
+// Replies to a group of commands sent at once, the group is done when every command is answered.
+// Same command may be in the group several times, replies are matched in the order of requests.
+class PendingReplies {
+public:
+  void begin();
+  void add(uint8_t zone, Command command_code);
+  // Marks the request as answered right away, e.g. when it could not be sent
+  void reject(size_t index, Answer answer_code);
+  // Payload of a streamed reply arrives in parts before the reply itself
+  void append_data(uint8_t zone, Command command_code, const uint8_t *data, size_t length);
+  void discard_data(uint8_t zone, Command command_code);
+  // Returns true when the reply completed the group
+  bool handle_reply(uint8_t zone, Command command_code, Answer answer_code, const uint8_t *data, size_t length);
+  // Gives up on all requests still waiting for a reply, they stay unanswered
+  void abort() { pending_ = 0; }
+  void reset();
+
+  bool is_active() const { return active_; }
+  bool is_complete() const { return pending_ == 0; }
+  bool is_successful() const;
+  size_t pending() const { return pending_; }
+  const std::vector<PendingReply>& replies() const { return replies_; }
+  // Replies as comma separated "zone command answer:data" hex, e.g. "010D00:2D"
+  std::string to_string() const;
+
+private:
+  bool active_ = false;
+  size_t pending_ = 0;
+  std::vector<PendingReply> replies_;
+
+  PendingReply *find_pending(uint8_t zone, Command command_code);
+};
+
+}  // namespace amplifier_serial
+}  // namespace esphome
@@ -0,0 +1,85 @@
+#include "esphome/core/log.h"
+#include "preset.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+static const char *TAG = "amplifier_serial.preset";
+
+bool is_preset_command(Command command_code) {
+  switch (command_code) {
+    case Command::INPUT_SOURCE:
+    case Command::VOLUME:
+    case Command::ROOM_EQ:
+    case Command::BALANCE:
+    case Command::DAC_FILTER:
+    case Command::DIRECT_MODE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::vector<RequestFrame> PresetTransaction::begin(const Preset& preset, const SettingsCache& cache, const SourceStateTable& source_states) {
+  this->failed_ = false;
+  this->name_ = preset.name;
+
+  // Input the per input settings will apply to
+  uint8_t target_source = VALUE_UNKNOWN;
+  auto current_source = cache.find(Command::INPUT_SOURCE);
+  if (current_source != cache.end()) {
+    target_source = current_source->second;
+  }
+  for (const auto& setting : preset.settings) {
+    if (setting.command_code == Command::INPUT_SOURCE) {
+      target_source = setting.value & 0x0F;
+    }
+  }
+
+  std::vector<RequestFrame> changes;
+  for (const auto& setting : preset.settings) {
+    bool unchanged;
+    if (is_per_input_command(setting.command_code)) {
+      // Unknown state of the target input is never assumed to match
+      uint8_t cached = target_source == VALUE_UNKNOWN ? VALUE_UNKNOWN : source_states.get_value(setting.command_code, target_source);
+      unchanged = cached < VALUE_UNSUPPORTED && cached == setting.value;
+    } else {
+      auto cached = cache.find(setting.command_code);
+      unchanged = cached != cache.end() && cached->second == setting.value;
+    }
+    if (unchanged) {
+      ESP_LOGV(TAG, "%s already set to %02X", command_to_string(setting.command_code), setting.value);
+      continue;
+    }
+
+    if (!is_per_input_command(setting.command_code)) {
+      changes.push_back(RequestFrame{.zone = 1, .command_code = setting.command_code, .data = {setting.value}});
+    } else if (target_source != VALUE_UNKNOWN) {
+      changes.push_back(RequestFrame{.zone = 1, .command_code = setting.command_code, .data = {target_source, setting.value}});
+    } else {
+      ESP_LOGW(TAG, "Preset %s: input unknown, cannot set %s", this->name_.c_str(), command_to_string(setting.command_code));
+      this->failed_ = true;
+    }
+  }
+
+  // Per input settings carry the target input, so they can be sent in any order with the input switch
+  return changes;
+}
+
+bool PresetTransaction::handle_reply(const ResponseFrame& frame) {
+  size_t pending = this->replies_.pending();
+  bool complete = this->replies_.handle_reply(frame.zone, frame.command_code, frame.answer_code, frame.data.data(), frame.data.size());
+  if (this->replies_.pending() < pending && frame.answer_code != Answer::STATUS_UPDATE) {
+    ESP_LOGW(TAG, "Preset %s: %s failed with %s", this->name_.c_str(),
+             command_to_string(frame.command_code), answer_to_string(frame.answer_code));
+  }
+  return complete;
+}
+
+void PresetTransaction::reset() {
+  this->failed_ = false;
+  this->replies_.reset();
+}
+
+}  // namespace amplifier_serial
+}  // namespace esphome
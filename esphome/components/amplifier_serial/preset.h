@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pending_replies.h"
+#include "protocol.h"
+#include "source_state.h"
+#include "units.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+const uint32_t PRESET_TIMEOUT = 5 * units::SECOND;
+
+struct PresetSetting {
+  Command command_code;
+  uint8_t value;
+};
+
+struct Preset {
+  std::string name;
+  std::vector<PresetSetting> settings;
+};
+
+// Last known single byte value of settings that presets can change, per input settings are in SourceStateTable
+using SettingsCache = std::unordered_map<Command, uint8_t>;
+
+bool is_preset_command(Command command_code);
+
+// Applies a preset as one transaction: only settings that differ from the cache are sent,
+// and the result is known after every one of them is answered.
+// Per input settings are compared with the input the preset switches to.
+class PresetTransaction {
+public:
+  // Returns the commands that have to be sent, empty if the device is already in the preset state
+  std::vector<RequestFrame> begin(const Preset& preset, const SettingsCache& cache, const SourceStateTable& source_states);
+  // Returns true when the reply completed the transaction
+  bool handle_reply(const ResponseFrame& frame);
+  void reset();
+
+  PendingReplies& replies() { return replies_; }
+  bool is_active() const { return replies_.is_active(); }
+  bool is_successful() const { return replies_.is_successful() && !failed_; }
+  const std::string& name() const { return name_; }
+
+private:
+  bool failed_ = false;  // Some settings could not be sent at all
+  std::string name_;
+  PendingReplies replies_;
+};
+
+}  // namespace amplifier_serial
+}  // namespace esphome
@@ -139,6 +139,63 @@ const char* source_to_string(uint8_t source) {
   }
 }
 
+const char* sample_rate_to_string(uint8_t sample_rate) {
+  switch (sample_rate) {
+    case 0x00:
+      return "32 kHz";
+    case 0x01:
+      return "44.1 kHz";
+    case 0x02:
+      return "48 kHz";
+    case 0x03:
+      return "88.2 kHz";
+    case 0x04:
+      return "96 kHz";
+    case 0x05:
+      return "176.4 kHz";
+    case 0x06:
+      return "192 kHz";
+    case 0x08:
+      return "Undetected";
+    default:
+      return "Unknown";
+  }
+}
+
+const char* audio_encoder_to_string(uint8_t encoder) {
+  switch (encoder) {
+    case 0x00:
+      return "MP3";
+    case 0x01:
+      return "WMA";
+    case 0x02:
+      return "AAC";
+    case 0x03:
+      return "FLAC";
+    case 0x04:
+      return "ALAC";
+    case 0x05:
+      return "WAV";
+    case 0x06:
+      return "Vorbis";
+    case 0x07:
+      return "MQA";
+    default:
+      return "Unknown";
+  }
+}
+
+const char* phono_input_type_to_string(uint8_t type) {
+  switch (type) {
+    case 0x00:
+      return "MM";
+    case 0x01:
+      return "MC";
+    default:
+      return "Unknown";
+  }
+}
+
 uint32_t standby_timeout_to_ms(uint8_t timeout_value) {
   switch (timeout_value) {
     case 0x00:
@@ -156,7 +213,7 @@ uint32_t standby_timeout_to_ms(uint8_t timeout_value) {
   }
 }
 
-FrameHandler::FrameHandler(std::function<void(const ResponseFrame&)> frame_handler)
+FrameHandler::FrameHandler(FrameCallback frame_handler)
   : frame_handler_(frame_handler) {}
 
 void FrameHandler::deserialize_frame_byte(uint8_t byte) {
@@ -187,35 +244,67 @@ void FrameHandler::deserialize_frame_byte(uint8_t byte) {
     case State::READ_LENGTH:
       this->current_frame_.data_length = byte;
       this->current_frame_.data.clear();
+      this->data_received_ = 0;
+      this->chunk_length_ = 0;
+      // Errors are short and handled by the transport, only stream actual payloads
+      this->streaming_ = this->chunk_handler_ &&
+                         this->current_frame_.answer_code == Answer::STATUS_UPDATE &&
+                         this->streamed_commands_.count(this->current_frame_.command_code);
       if (this->current_frame_.data_length == 0) {
         this->state_ = State::READ_END;
       } else {
-        this->current_frame_.data.reserve(this->current_frame_.data_length);
+        if (!this->streaming_) {
+          this->current_frame_.data.reserve(this->current_frame_.data_length);
+        }
         this->state_ = State::READ_DATA;
       }
       break;
 
     case State::READ_DATA:
-      this->current_frame_.data.push_back(byte);
-      if (this->current_frame_.data.size() >= this->current_frame_.data_length) {
+      this->data_received_++;
+      if (this->streaming_) {
+        this->chunk_[this->chunk_length_++] = byte;
+        // Last chunk is held back until the end char confirms the frame
+        if (this->chunk_length_ >= CHUNK_SIZE && this->data_received_ < this->current_frame_.data_length) {
+          this->emit_chunk(ChunkEvent::DATA);
+        }
+      } else {
+        this->current_frame_.data.push_back(byte);
+      }
+      if (this->data_received_ >= this->current_frame_.data_length) {
         this->state_ = State::READ_END;
       }
       break;
 
     case State::READ_END:
       if (byte == END_CHAR) {
-        if (this->frame_handler_) {
+        if (this->streaming_) {
+          this->emit_chunk(ChunkEvent::END);
+        } else if (this->frame_handler_) {
           this->frame_handler_(this->current_frame_);
         }
       } else {
         ESP_LOGW(TAG, "Invalid frame received");
+        if (this->streaming_) {
+          this->emit_chunk(ChunkEvent::ABORT);
+        }
       }
+      this->streaming_ = false;
       this->state_ = State::READ_START;
       break;
   }
 }
 
+void FrameHandler::emit_chunk(ChunkEvent event) {
+  this->chunk_handler_(this->current_frame_, event, this->chunk_.data(), event == ChunkEvent::ABORT ? 0 : this->chunk_length_);
+  this->chunk_length_ = 0;
+}
+
 void FrameHandler::reset_state() {
+  if (this->streaming_ && this->state_ != State::READ_START) {
+    this->emit_chunk(ChunkEvent::ABORT);
+  }
+  this->streaming_ = false;
   this->state_ = State::READ_START;
   this->current_frame_ = ResponseFrame();
 }
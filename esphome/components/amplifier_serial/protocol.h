@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "units.h"
@@ -74,8 +76,12 @@ const uint8_t END_CHAR = 0x0D;
 const uint16_t UART_SPEED = 38400;
 
 const uint32_t INIT_TIME = 6 * units::SECOND;
+const uint32_t INIT_RETRY_DELAY = 300;  // Retry period of queries the unit rejects while still booting
+const uint8_t SYSTEM_STATUS_MAX_RETRIES = 3;  // Then initialization starts over with the next update
 const uint8_t MAX_VOLUME = 99;
 
+const size_t CHUNK_SIZE = 32;  // Payload bytes buffered before a streamed chunk is passed on
+
 struct RequestFrame {
   uint8_t zone;
   Command command_code;
@@ -90,13 +96,26 @@ struct ResponseFrame {
   std::vector<uint8_t> data;
 };
 
+enum class ChunkEvent : uint8_t {
+  DATA,   // Part of the payload, more will follow
+  END,    // Frame completed, carries the remaining (possibly empty) part of the payload
+  ABORT,  // Frame was invalid or timed out, everything received so far should be dropped
+};
+
+using FrameCallback = std::function<void(const ResponseFrame&)>;
+// Streamed frames are passed without data, payload is delivered in chunks as it arrives
+using ChunkCallback = std::function<void(const ResponseFrame&, ChunkEvent, const uint8_t*, size_t)>;
+
 class FrameHandler {
 public:
   FrameHandler() = default;
-  FrameHandler(std::function<void(const ResponseFrame&)> frame_handler);
+  FrameHandler(FrameCallback frame_handler);
   void deserialize_frame_byte(uint8_t byte);
   std::vector<uint8_t> serialize_frame(const RequestFrame& frame);
-  inline void set_frame_handler(std::function<void(const ResponseFrame&)> frame_handler) { frame_handler_ = frame_handler; }
+  inline void set_frame_handler(FrameCallback frame_handler) { frame_handler_ = frame_handler; }
+  inline void set_chunk_handler(ChunkCallback chunk_handler) { chunk_handler_ = chunk_handler; }
+  // Successful responses to this command will be streamed to the chunk handler instead of being buffered
+  inline void stream_command(Command command_code) { streamed_commands_.insert(command_code); }
   bool is_idle() const { return state_ == State::READ_START; }
   void reset_state();
 
@@ -113,12 +132,24 @@ private:
 
   State state_ = State::READ_START;
   ResponseFrame current_frame_;
-  std::function<void(const ResponseFrame&)> frame_handler_ = nullptr;
+  FrameCallback frame_handler_ = nullptr;
+  ChunkCallback chunk_handler_ = nullptr;
+  std::unordered_set<Command> streamed_commands_;
+
+  bool streaming_ = false;
+  uint8_t data_received_ = 0;
+  uint8_t chunk_length_ = 0;
+  std::array<uint8_t, CHUNK_SIZE> chunk_;
+
+  void emit_chunk(ChunkEvent event);
 };
 
 const char* command_to_string(Command command_code);
 const char* answer_to_string(Answer answer_code);
 const char* source_to_string(uint8_t source);
+const char* sample_rate_to_string(uint8_t sample_rate);
+const char* audio_encoder_to_string(uint8_t encoder);
+const char* phono_input_type_to_string(uint8_t type);
 uint32_t standby_timeout_to_ms(uint8_t timeout_value);
 
 const std::string to_hex_string(const std::vector<uint8_t> &data);
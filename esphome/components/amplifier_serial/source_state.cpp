@@ -0,0 +1,70 @@
+#include "source_state.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+bool is_per_input_command(Command command_code) {
+  switch (command_code) {
+    case Command::DIRECT_MODE:
+    case Command::PROCESSOR_MODE_INPUT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+uint8_t SourceStateTable::get_value(Command command_code, uint8_t source) const {
+  const SourceState& state = this->states_[source & 0x0F];
+  switch (command_code) {
+    case Command::DIRECT_MODE:
+      return state.direct_mode;
+    case Command::PROCESSOR_MODE_INPUT:
+      return state.processor_mode;
+    case Command::PHONO_INPUT_TYPE:
+      return state.phono_input_type;
+    default:
+      return VALUE_UNKNOWN;
+  }
+}
+
+void SourceStateTable::store(Command command_code, uint8_t source, uint8_t value) {
+  SourceState& state = this->get(source);
+  switch (command_code) {
+    case Command::DIRECT_MODE:
+      state.direct_mode = value;
+      break;
+    case Command::PROCESSOR_MODE_INPUT:
+      state.processor_mode = value;
+      break;
+    case Command::PHONO_INPUT_TYPE:
+      state.phono_input_type = value;
+      break;
+    default:
+      break;
+  }
+}
+
+bool SourceStateTable::next_prefetch(Command &command_code, uint8_t &source) {
+  static const Command PREFETCH_COMMANDS[] = {Command::DIRECT_MODE, Command::PROCESSOR_MODE_INPUT, Command::PHONO_INPUT_TYPE};
+  const size_t command_count = sizeof(PREFETCH_COMMANDS) / sizeof(PREFETCH_COMMANDS[0]);
+  const size_t entry_count = sizeof(INPUT_SOURCES) * command_count;
+
+  for (size_t i = 0; i < entry_count; i++) {
+    size_t entry = (this->prefetch_cursor_ + i) % entry_count;
+    uint8_t input = INPUT_SOURCES[entry / command_count];
+    Command command = PREFETCH_COMMANDS[entry % command_count];
+    if (command == Command::PHONO_INPUT_TYPE && input != PHONO_SOURCE) {
+      continue;
+    }
+    if (this->get_value(command, input) == VALUE_UNKNOWN) {
+      this->prefetch_cursor_ = entry + 1;
+      command_code = command;
+      source = input;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace amplifier_serial
+}  // namespace esphome
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "protocol.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+const uint8_t INPUT_SOURCES[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0B};
+const uint8_t PHONO_SOURCE = 0x01;
+const uint8_t NET_USB_SOURCE = 0x0B;  // Only input with now playing info
+
+const uint8_t VALUE_UNKNOWN = 0xFF;
+const uint8_t VALUE_UNSUPPORTED = 0xFE;
+
+// Settings the unit keeps separately for every input. They are set with {input, value},
+// queried with {input, STATUS_REQUEST} and replies carry {input, value}.
+bool is_per_input_command(Command command_code);
+
+struct SourceState {
+  uint8_t direct_mode = VALUE_UNKNOWN;
+  uint8_t processor_mode = VALUE_UNKNOWN;
+  uint8_t phono_input_type = VALUE_UNKNOWN;
+};
+
+// Settings the unit keeps per input, cached so they are known before switching to the input
+class SourceStateTable {
+public:
+  SourceState& get(uint8_t source) { return states_[source & 0x0F]; }
+  // Cached value of the setting for the input, VALUE_UNKNOWN for commands that are not per input
+  uint8_t get_value(Command command_code, uint8_t source) const;
+  void store(Command command_code, uint8_t source, uint8_t value);
+  void clear() {
+    states_.fill(SourceState());
+    prefetch_cursor_ = 0;
+  }
+
+  // Next per input query whose value is still unknown, returns false when the table is complete.
+  // Scanning continues after the previous query, so an entry that keeps failing doesn't block the others.
+  bool next_prefetch(Command &command_code, uint8_t &source);
+
+private:
+  std::array<SourceState, 16> states_;
+  size_t prefetch_cursor_ = 0;
+};
+
+}  // namespace amplifier_serial
+}  // namespace esphome
@@ -0,0 +1,45 @@
+#include <algorithm>
+#include "telemetry.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+void WindowStats::add(float value) {
+  if (this->count_ == 0) {
+    this->min_ = this->max_ = value;
+    this->sum_ = 0;
+  }
+  this->min_ = std::min(this->min_, value);
+  this->max_ = std::max(this->max_, value);
+  this->sum_ += value;
+  this->count_++;
+}
+
+void TemperatureTelemetry::add(float value) {
+  this->stats.add(value);
+  this->last = value;
+}
+
+void TemperatureTelemetry::publish_window() {
+  if (!this->stats.has_samples()) {
+    return;
+  }
+  if (this->average_sensor != nullptr) {
+    this->average_sensor->publish_state(this->stats.average());
+  }
+  if (this->min_sensor != nullptr) {
+    this->min_sensor->publish_state(this->stats.min());
+  }
+  if (this->max_sensor != nullptr) {
+    this->max_sensor->publish_state(this->stats.max());
+  }
+  this->stats.reset();
+}
+
+void TemperatureTelemetry::reset() {
+  this->stats.reset();
+  this->last = NAN;
+}
+
+}  // namespace amplifier_serial
+}  // namespace esphome
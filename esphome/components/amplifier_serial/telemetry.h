@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "esphome/components/sensor/sensor.h"
+#include "units.h"
+
+namespace esphome {
+namespace amplifier_serial {
+
+const uint32_t TELEMETRY_INTERVAL = 10 * units::SECOND;
+const uint32_t TELEMETRY_WINDOW = 5 * units::MINUTE;
+const float TEMPERATURE_THRESHOLD = 70.0f;
+const float TEMPERATURE_HYSTERESIS = 5.0f;
+
+// Min, max and average of samples collected since the last reset
+class WindowStats {
+public:
+  void add(float value);
+  void reset() { count_ = 0; }
+
+  bool has_samples() const { return count_ > 0; }
+  float min() const { return min_; }
+  float max() const { return max_; }
+  float average() const { return sum_ / count_; }
+
+private:
+  float min_ = 0;
+  float max_ = 0;
+  float sum_ = 0;
+  uint16_t count_ = 0;
+};
+
+// Temperature that is sampled often but published only as aggregates once per window
+struct TemperatureTelemetry {
+  WindowStats stats;
+  float last{NAN};  // Latest sample, survives the window reset so threshold checks don't depend on it
+  sensor::Sensor *average_sensor{nullptr};
+  sensor::Sensor *min_sensor{nullptr};
+  sensor::Sensor *max_sensor{nullptr};
+
+  bool has_sensors() const { return average_sensor != nullptr || min_sensor != nullptr || max_sensor != nullptr; }
+  void add(float value);
+  void publish_window();
+  void reset();
+};
+
+}  // namespace amplifier_serial
+}  // namespace esphome
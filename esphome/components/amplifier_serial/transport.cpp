@@ -29,6 +29,13 @@ void SerialTransport::read_available_bytes() {
   }
 }
 
+bool SerialTransport::is_link_quiet() const {
+  uint32_t current_time = millis();
+  return this->frame_handler_.is_idle() &&
+         current_time - this->last_byte_time_ > LINK_QUIET_TIME &&
+         current_time - this->last_send_time_ > LINK_QUIET_TIME;
+}
+
 bool SerialTransport::send_command(Command command_code, const vector<uint8_t>& data, uint8_t zone) {
   if (unsupported_commands_.count(command_code)) {
     ESP_LOGD(TAG, "Not sending unsupported command: %s (%02X)", 
@@ -46,6 +53,8 @@ bool SerialTransport::send_command(Command command_code, const vector<uint8_t>&
            command_to_string(frame.command_code), static_cast<uint8_t>(frame.command_code),
            to_hex_string(frame.data).c_str(), frame.zone);  
 
+  this->on_send();
+  this->last_send_time_ = millis();
   this->write_array(this->frame_handler_.serialize_frame(frame));
 
   return true;
@@ -17,6 +17,7 @@ namespace esphome {
 namespace amplifier_serial {
 
 const uint32_t FRAME_TIMEOUT_MS = 3 * units::SECOND;
+const uint32_t LINK_QUIET_TIME = 1 * units::SECOND;  // Replies arrive well within this time after a request
 
 class SerialTransport : public UARTDevice {
  public:
@@ -27,13 +28,20 @@ class SerialTransport : public UARTDevice {
 
   bool send_command(Command command_code, const vector<uint8_t>& data, uint8_t zone=1);
   inline bool send_command(Command command_code, uint8_t data, uint8_t zone=1) { return this->send_command(command_code, vector<uint8_t>{data}, zone); }
-  void set_frame_handler(function<void(const ResponseFrame&)> handler) { frame_handler_.set_frame_handler(handler); }
+  void set_frame_handler(FrameCallback handler) { frame_handler_.set_frame_handler(handler); }
+  void set_chunk_handler(ChunkCallback handler) { frame_handler_.set_chunk_handler(handler); }
+  void stream_command(Command command_code) { frame_handler_.stream_command(command_code); }
+  // No partially received frame and nothing sent or received recently
+  bool is_link_quiet() const;
 
  protected:
   FrameHandler frame_handler_;
   unordered_set<Command> unsupported_commands_;
   uint32_t last_byte_time_ = 0;
+  uint32_t last_send_time_ = 0;
 
+  // Called before every request, so the owner can resume reading replies
+  virtual void on_send() {}
   void read_available_bytes();
   bool handle_frame(const ResponseFrame& frame);
 };